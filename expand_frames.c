@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+Turns a log printed with -x back into the full format: every range of frames in a frame list, like
+[0-3,8], is written out frame by frame, [0,1,2,3,8]. Reads the log on standard input and writes it to
+standard output, lines without frame lists are passed through as they are.
+*/
+
+#define FRAMES "frames=["
+
+// Writes out one frame list, text points just past its '[', returns where the list ends
+static char* expand_list(char* text) {
+    int first = 1;
+    putchar('[');
+    while (*text != ']' && *text != '\0' && *text != '\n') {
+        char* end;
+        long from = strtol(text, &end, 10);
+        long to = from;
+        if (end == text) {
+            break;
+        }
+        if (*end == '-') {
+            text = end + 1;
+            to = strtol(text, &end, 10);
+        }
+        for (long frame=from; frame<=to; frame++) {
+            printf(first ? "%ld" : ",%ld", frame);
+            first = 0;
+        }
+        text = *end == ',' ? end + 1 : end;
+    }
+    return text;
+}
+
+int main(void) {
+    char* line = NULL;
+    size_t capt = 0;
+    while (getline(&line, &capt, stdin) != -1) {
+        char* text = line;
+        char* list;
+        while ((list = strstr(text, FRAMES)) != NULL) {
+            list += strlen(FRAMES);
+            fwrite(text, 1, list - text - 1, stdout);
+            text = expand_list(list);
+        }
+        fputs(text, stdout);
+    }
+    free(line);
+    return 0;
+}
@@ -0,0 +1,250 @@
+#include "ingest.h"
+#include "process.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#define INGEST_MIN_CHUNK (16*1024)  // smallest piece of a trace worth a thread of its own
+#define INGEST_LINE 256             // longest line read, as for a trace read from a stream
+
+// A piece of the trace and the processes parsed from it
+typedef struct {
+    char* text;
+    size_t begin, end;          // offsets of the piece in the text, starting and ending on a line
+    Process_t* array;
+    int total;
+    int stopped;                // boolean value if a line that is not a process ended the piece, and the trace
+} Ingest_chunk_t;
+
+// A merge of two neighbouring sorted runs from src into dst
+typedef struct {
+    Process_t* src;
+    Process_t* dst;
+    int begin, middle, end;
+} Ingest_merge_t;
+
+static int in_order(Process_t* array, int total) {
+    for (int i=1; i<total; i++) {
+        if (array[i].start_time < array[i-1].start_time) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static void merge_runs(Process_t* src, Process_t* dst, int begin, int middle, int end) {
+    int i = begin, j = middle, k = begin;
+    while (i < middle && j < end) {
+        // ties are taken from the left run, it came first in the trace
+        if (src[j].start_time < src[i].start_time) {
+            dst[k++] = src[j++];
+        } else {
+            dst[k++] = src[i++];
+        }
+    }
+    memcpy(&dst[k], &src[i], sizeof(Process_t)*(middle - i));
+    k += middle - i;
+    memcpy(&dst[k], &src[j], sizeof(Process_t)*(end - j));
+}
+
+static void* merge_worker(void* data) {
+    Ingest_merge_t* merge = (Ingest_merge_t*) data;
+    merge_runs(merge->src, merge->dst, merge->begin, merge->middle, merge->end);
+    return NULL;
+}
+
+// Stable bottom up merge sort by start time
+static void sort_processes(Process_t* array, int total) {
+    if (in_order(array, total)) {
+        return;
+    }
+    Process_t* buffer = (Process_t*) malloc(sizeof(Process_t)*total);
+    assert(buffer);
+    Process_t* src = array;
+    Process_t* dst = buffer;
+    for (int width=1; width<total; width*=2) {
+        for (int begin=0; begin<total; begin+=2*width) {
+            int middle = begin + width < total ? begin + width : total;
+            int end = begin + 2*width < total ? begin + 2*width : total;
+            merge_runs(src, dst, begin, middle, end);
+        }
+        Process_t* swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != array) {
+        memcpy(array, src, sizeof(Process_t)*total);
+    }
+    free(buffer);
+}
+
+// Parses the processes of one chunk, then sorts them
+static void* parse_chunk(void* data) {
+    Ingest_chunk_t* chunk = (Ingest_chunk_t*) data;
+    int capt = 2;
+    chunk->array = (Process_t*) malloc(sizeof(Process_t)*capt);
+    assert(chunk->array);
+    char line[INGEST_LINE];
+    size_t pos = chunk->begin;
+    while (pos < chunk->end) {
+        char* eol = memchr(&chunk->text[pos], '\n', chunk->end - pos);
+        size_t next = eol != NULL ? (size_t)(eol - chunk->text) + 1 : chunk->end;
+        size_t len = next - pos < INGEST_LINE ? next - pos : INGEST_LINE - 1;
+        memcpy(line, &chunk->text[pos], len);
+        line[len] = '\0';
+        pos = next;
+
+        int parsed = parse_process(line, &chunk->array[chunk->total]);
+        if (parsed == 0) {
+            continue;
+        }
+        if (parsed < 0) {
+            chunk->stopped = TRUE;
+            break;
+        }
+        chunk->total += 1;
+        if (chunk->total == capt) {
+            capt *= 2;
+            chunk->array = (Process_t*) realloc(chunk->array, sizeof(Process_t)*capt);
+            assert(chunk->array);
+        }
+    }
+    sort_processes(chunk->array, chunk->total);
+    return NULL;
+}
+
+// Merges neighbouring runs pairwise, each pair on its own thread, until one run is left. Run i begins at
+// bounds[i] and bounds[runs] is the total.
+static void merge_chunks(Process_t* array, int* bounds, int runs) {
+    int total = bounds[runs];
+    if (runs <= 1 || in_order(array, total)) {
+        return;
+    }
+    Process_t* buffer = (Process_t*) malloc(sizeof(Process_t)*total);
+    assert(buffer);
+    Ingest_merge_t* merges = (Ingest_merge_t*) malloc(sizeof(Ingest_merge_t)*runs);
+    assert(merges);
+    pthread_t* workers = (pthread_t*) malloc(sizeof(pthread_t)*runs);
+    assert(workers);
+    Process_t* src = array;
+    Process_t* dst = buffer;
+    while (runs > 1) {
+        int pairs = runs/2;
+        for (int p=0; p<pairs; p++) {
+            Ingest_merge_t merge = {src, dst, bounds[2*p], bounds[2*p + 1], bounds[2*p + 2]};
+            merges[p] = merge;
+            if (p > 0) {
+                int created = pthread_create(&workers[p], NULL, merge_worker, &merges[p]);
+                assert(created == 0);
+            }
+        }
+        if (runs % 2 == 1) {
+            memcpy(&dst[bounds[runs - 1]], &src[bounds[runs - 1]], sizeof(Process_t)*(total - bounds[runs - 1]));
+        }
+        merge_worker(&merges[0]);
+        for (int p=1; p<pairs; p++) {
+            pthread_join(workers[p], NULL);
+        }
+        // each merged run begins where the left run of its pair did
+        for (int i=0; i<runs; i+=2) {
+            bounds[i/2] = bounds[i];
+        }
+        runs = (runs + 1)/2;
+        bounds[runs] = total;
+        Process_t* swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != array) {
+        memcpy(array, src, sizeof(Process_t)*total);
+    }
+    free(workers);
+    free(merges);
+    free(buffer);
+}
+
+// Parses a trace held in memory on up to 'threads' threads, into a list in arrival order
+Process_list_t* get_processes_from_text(char* text, size_t len, int threads) {
+    int chunks = len/INGEST_MIN_CHUNK;
+    if (chunks > threads) chunks = threads;
+    if (chunks < 1) chunks = 1;
+    Ingest_chunk_t* chunk = (Ingest_chunk_t*) calloc(chunks, sizeof(Ingest_chunk_t));
+    assert(chunk);
+    size_t begin = 0;
+    for (int i=0; i<chunks; i++) {
+        // each chunk ends after the line its share of the text ends in
+        size_t end = i == chunks - 1 ? len : len/chunks*(i + 1);
+        if (end < begin) end = begin;
+        while (end < len && (end == 0 || text[end - 1] != '\n')) end++;
+        chunk[i].text = text;
+        chunk[i].begin = begin;
+        chunk[i].end = end;
+        begin = end;
+    }
+
+    pthread_t* workers = (pthread_t*) malloc(sizeof(pthread_t)*chunks);
+    assert(workers);
+    for (int i=1; i<chunks; i++) {
+        int created = pthread_create(&workers[i], NULL, parse_chunk, &chunk[i]);
+        assert(created == 0);
+    }
+    parse_chunk(&chunk[0]);
+    for (int i=1; i<chunks; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+
+    // a line that is not a process ends the trace, the chunks after it are dropped
+    int used = chunks;
+    for (int i=0; i<chunks; i++) {
+        if (chunk[i].stopped) {
+            used = i + 1;
+            break;
+        }
+    }
+    int* bounds = (int*) malloc(sizeof(int)*(used + 1));
+    assert(bounds);
+    bounds[0] = 0;
+    for (int i=0; i<used; i++) {
+        bounds[i + 1] = bounds[i] + chunk[i].total;
+    }
+
+    Process_list_t* processes = (Process_list_t*) malloc(sizeof(Process_list_t));
+    assert(processes);
+    processes->total_processes = bounds[used];
+    processes->array = (Process_t*) malloc(sizeof(Process_t)*(processes->total_processes + 1));
+    assert(processes->array);
+    for (int i=0; i<chunks; i++) {
+        if (i < used) {
+            memcpy(&processes->array[bounds[i]], chunk[i].array, sizeof(Process_t)*chunk[i].total);
+        } else {
+            for (int j=0; j<chunk[i].total; j++) {
+                free(chunk[i].array[j].page_table);
+            }
+        }
+        free(chunk[i].array);
+    }
+    merge_chunks(processes->array, bounds, used);
+    free(bounds);
+    free(chunk);
+    return processes;
+}
+
+// Loads all processes of a trace file on up to 'threads' threads, into a list in arrival order
+Process_list_t* get_processes_parallel(char* filepath, int threads) {
+    FILE* fptr = fopen(filepath, "r");
+    assert(fptr);
+    fseek(fptr, 0, SEEK_END);
+    long len = ftell(fptr);
+    assert(len >= 0);
+    rewind(fptr);
+    char* text = (char*) malloc(len + 1);
+    assert(text);
+    size_t read = fread(text, 1, len, fptr);
+    fclose(fptr);
+    Process_list_t* processes = get_processes_from_text(text, read, threads);
+    free(text);
+    return processes;
+}
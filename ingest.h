@@ -0,0 +1,16 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+#include "process.h"
+#include <stddef.h>
+
+/*
+Parallel trace loading. The trace is split into chunks on line boundaries, each parsed on its own thread into
+its own array, and the chunks are put back together in arrival order with a stable merge sort, so processes
+that arrive together stay in the order of the trace.
+*/
+
+Process_list_t* get_processes_parallel(char* filepath, int threads);
+Process_list_t* get_processes_from_text(char* text, size_t len, int threads);
+
+#endif
@@ -3,27 +3,168 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <string.h>
 #include <strings.h>
 #include <assert.h>
 #include "process.h"
 #include "memory.h"
+#include "snapshot.h"
+#include "sim.h"
+#include "profile.h"
+#include "tune.h"
+#include "server.h"
+#include "ingest.h"
 
 
-Process_list_t* get_processes_from_input(char* filepath);
-
 int main(int argc, char** argv) {
-    char* filepath;
-    int quantum, alloc_mode, c = 0;
+    char* filepath = NULL;
+    char* resume_path = NULL;
+    char* serve_path = NULL;
+    char* client_path = NULL;
+    int alloc_mode = INFINITE, mode_given = FALSE, c = 0, profile = FALSE;
+    int tune = FALSE, tune_policies = FALSE, threads = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int qmin = 0, qmax = 0;
+    Sim_options_t options = {0};
+    // options that only have a long form
+    enum { OPT_PROFILE = 256 };
+    struct option long_options[] = {
+        {"profile", no_argument, NULL, OPT_PROFILE},
+        {NULL, 0, NULL, 0}
+    };
     // read in all flags/options given from agrv
-    while ((c = getopt (argc, argv, "f:q:m:")) != -1) {
+    while ((c = getopt_long(argc, argv, "f:q:m:H:ls:c:C:r:pt:T:n:P:d:w:aA:j:M:S:U:z:x", long_options, NULL)) != -1) {
         switch (c) {
+            case OPT_PROFILE:
+                // time the simulator's phases and print a breakdown at the end
+                profile = TRUE;
+                prof_enable();
+                break;
+
             case 'f':
                 filepath = strdup(optarg);
                 break;
 
             case 'q':
-                quantum = atoi(optarg);
+                options.quantum = atoi(optarg);
+                break;
+
+            case 'l':
+                // hold arrivals back, and suspend admitted processes, while their working sets overcommit memory
+                options.load_control = TRUE;
+                break;
+
+            case 's':
+                // memory aware scheduling, how far down the queue to look for a process in memory
+                options.resident_window = atoi(optarg);
+                break;
+
+            case 'c':
+                // cycle at which to save a snapshot of the simulation
+                options.checkpoint_cycle = atoi(optarg);
+                break;
+
+            case 'C':
+                options.checkpoint_file = strdup(optarg);
+                break;
+
+            case 'r':
+                // pick up a simulation from a snapshot instead of starting at cycle 0
+                resume_path = strdup(optarg);
+                break;
+
+            case 'p':
+                // report percentiles of turnaround, overhead and wait time
+                options.percentiles = TRUE;
+                break;
+
+            case 't':
+                // sample queue length and memory pressure every so many cycles
+                options.telemetry_interval = atoi(optarg);
+                break;
+
+            case 'T':
+                // where the -t samples are saved, CSV if the name ends in .csv, without it they go to stderr
+                options.telemetry_file = strdup(optarg);
+                break;
+
+            case 'n':
+                // split paged/virtual memory over several NUMA nodes, at most one per frame
+                options.numa_nodes = atoi(optarg);
+                break;
+
+            case 'P':
+                if (strcasecmp(optarg, "local") == 0) {
+                    options.numa_policy = NUMA_LOCAL;
+                } else if (strcasecmp(optarg, "interleave") == 0) {
+                    options.numa_policy = NUMA_INTERLEAVE;
+                } else if (strcasecmp(optarg, "spill") == 0) {
+                    options.numa_policy = NUMA_SPILL;
+                }
+                break;
+
+            case 'd':
+                // cycles a process stalls on being loaded with all of its pages on another node
+                options.remote_penalty = atoi(optarg);
+                break;
+
+            case 'w':
+                // processes sharing pages write this percent of them each time they run, copying on write
+                options.cow_writes = atoi(optarg);
+                break;
+
+            case 'a':
+                // report allocation cost and fragmentation for first-fit and segregated memory
+                options.alloc_stats = TRUE;
+                break;
+
+            case 'x':
+                // print frame lists as ranges of contiguous frames, expand_frames turns them back into lists
+                options.compact_frames = TRUE;
+                break;
+
+            case 'A': {
+                // tune the quantum over qmin:qmax, adding ":policies" also tries each policy of the memory model
+                char policies[16] = "";
+                tune = sscanf(optarg, "%u:%u:%15s", &qmin, &qmax, policies) >= 2 && qmin > 0 && qmin <= qmax;
+                tune_policies = strcasecmp(policies, "policies") == 0;
+                break;
+            }
+
+            case 'j':
+                // threads for loading the trace, tuning and the daemon's jobs
+                threads = atoi(optarg);
+                break;
+
+            case 'M': {
+                // memory size in KBs, rounded down to whole pages
+                int size = atoi(optarg);
+                if (size > 65532) size = 65532;
+                options.memory_size = size >= PAGESIZE ? size - size % PAGESIZE : 0;
+                break;
+            }
+
+            case 'z':
+                // compressed swap tier for virtual memory, percent:ratio:pool-latency:disk-latency
+                if (sscanf(optarg, "%d:%lf:%lf:%lf", &options.swap_percent, &options.swap_ratio,
+                        &options.swap_pool_latency, &options.swap_disk_latency) != 4 || options.swap_ratio <= 0) {
+                    options.swap_ratio = 0;
+                }
+                break;
+
+            case 'S':
+                // run as a daemon taking jobs on this Unix socket
+                serve_path = strdup(optarg);
+                break;
+
+            case 'U':
+                // send standard input to the daemon on this Unix socket
+                client_path = strdup(optarg);
+                break;
+
+            case 'H':
+                // small frames per huge frame, only used by paged and virtual memory on flat memory
+                options.huge_frames = atoi(optarg);
                 break;
 
             case 'm':
@@ -35,28 +176,92 @@ int main(int argc, char** argv) {
                     alloc_mode = PAGED;
                 } else if (strcasecmp(optarg, "virtual") == 0) {
                     alloc_mode = VIRTUAL;
+                } else if (strcasecmp(optarg, "segregated") == 0) {
+                    alloc_mode = SEGREGATED;
+                } else {
+                    break;
                 }
+                mode_given = TRUE;
                 break;
         }
     }
 
 
-    Process_list_t* processes = get_processes_from_input(filepath);
-    // run the appropiate simulation mode
-    switch (alloc_mode) {
-        case INFINITE:
-            simulate_infinite(processes, quantum, alloc_mode);
-            break;
-        case FIRSTFIT:
-            simulate_firstfit(processes, quantum, alloc_mode);
-            break;
-        case PAGED:
-            simulate_paged(processes, quantum, alloc_mode);
-            break;
-        case VIRTUAL:
-            simulate_virtual(processes, quantum, alloc_mode);
-            break;
+    if (options.huge_frames < 0) options.huge_frames = 0;
+    // NUMA placement hands out frames node by node and cannot keep huge groups aligned
+    if (options.huge_frames > 1 && options.numa_nodes > 1) {
+        fprintf(stderr, "huge frames (-H) cannot be combined with NUMA nodes (-n)\n");
+        free(filepath);
+        free(resume_path);
+        free(options.checkpoint_file);
+        free(options.telemetry_file);
+        return 1;
+    }
+
+    Process_list_t* processes;
+    Snapshot_t* snapshot = NULL;
+    Sim_t* sim;
+    options.alloc_mode = alloc_mode;
+    if (serve_path != NULL || client_path != NULL) {
+        int status = serve_path != NULL ? server_run(serve_path, threads) : server_client(client_path);
+        free(serve_path);
+        free(client_path);
+        free(filepath);
+        free(options.checkpoint_file);
+        free(options.telemetry_file);
+        return status;
+    }
+    if (tune && !mode_given) {
+        // every candidate is run on one memory model, which has to be named
+        fprintf(stderr, "tuning needs a memory model given with -m\n");
+        free(filepath);
+        free(resume_path);
+        free(options.checkpoint_file);
+        free(options.telemetry_file);
+        return 1;
+    }
+    if (tune || resume_path == NULL) {
+        processes = get_processes_parallel(filepath, threads);
+        // a process that never fits in memory would keep the simulation running forever
+        const char* problem = sim_check(processes, &options);
+        if (problem != NULL) {
+            fprintf(stderr, "%s\n", problem);
+            free_processes(processes);
+            free(filepath);
+            free(resume_path);
+            free(options.checkpoint_file);
+            free(options.telemetry_file);
+            return 1;
+        }
+    }
+    if (tune) {
+        // search for the best settings instead of running one simulation
+        Tune_t* search = tune_run(processes, &options, qmin, qmax, tune_policies, threads);
+        tune_print(search);
+        tune_free(search);
+        free_processes(processes);
+        free(filepath);
+        free(options.checkpoint_file);
+        free(options.telemetry_file);
+        return 0;
     }
+    if (resume_path != NULL) {
+        // the snapshot holds the processes and memory model, other options may differ from the saved run
+        snapshot = snapshot_load(resume_path);
+        processes = snapshot->processes;
+        sim = sim_resume(snapshot, &options);
+    } else {
+        sim = sim_create(processes, &options);
+    }
+    // run the simulation, printing every event as it happens
+    sim_set_event_handler(sim, sim_print_event, NULL);
+    prof_run_begin();
+    sim_run(sim);
+    prof_run_end();
+    sim_print_report(sim);
+    sim_save_telemetry(sim);
+    if (profile) prof_report(sim->events);
+    sim_destroy(sim);
     
     /*  
     !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
@@ -66,56 +271,11 @@ int main(int argc, char** argv) {
     !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
     */
     
-    for (int i = 0; i < processes->total_processes; i++) {
-        free(processes->array[i].page_table);
-    }
-    free(processes->array);
-    free(processes);
+    free_processes(processes);
     free(filepath);
+    free(resume_path);
+    free(snapshot);
+    free(options.checkpoint_file);
+    free(options.telemetry_file);
     return 0;
 }
-// Load all processes for the simulation into a list with the correct details
-Process_list_t* get_processes_from_input(char* filepath) {
-    int INITIAL_CAPT = 2; 
-    int GROWTH_FCT = 2;
-    int capt = INITIAL_CAPT;
-    
-    Process_list_t* processes = (Process_list_t*) malloc(sizeof(Process_list_t)); // struct holding all our processes
-    assert(processes);
-    processes->array = (Process_t*) malloc(sizeof(Process_t)*capt);
-    processes->total_processes = 0;
-    assert(processes->array);
-    
-    FILE* fptr = fopen(filepath, "r"); // open our case file
-    assert(fptr);
-
-    int i=0;
-    __uint32_t time, duration; 
-    __uint16_t memory;     
-    char PID[9];
-    while(fscanf(fptr, "%u %8s %u %hu", &time, PID, &duration, &memory) == 4) {
-        // loading attributes for each process
-        processes->array[i].pages = ceil(memory/(double)PAGESIZE); // avoid int division 
-        processes->array[i].page_table = (int*) malloc(sizeof(int)*processes->array[i].pages);
-        for (int j=0; j<processes->array[i].pages; j++) {
-            processes->array[i].page_table[j] = -1;
-        }
-        processes->array[i].start_time = time;
-        processes->array[i].duration = duration;
-        processes->array[i].service_time = duration;
-        processes->array[i].memory = memory;
-        processes->array[i].allocated = FALSE;
-        processes->array[i].state = NOT_READY;
-        strcpy(processes->array[i].PID, PID);
-        
-        i++;
-        if (i == capt) { // might expand more than needed
-            capt *= GROWTH_FCT;
-            processes->array = (Process_t*) realloc(processes->array, sizeof(Process_t)*capt);
-            assert(processes->array);
-        }
-    }
-    processes->total_processes = i; 
-    fclose(fptr);
-    return processes;
-}
\ No newline at end of file
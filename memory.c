@@ -1,10 +1,12 @@
 #include "memory.h"
 #include "process.h"
 #include "processqueue.h"
+#include "profile.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
+#include <math.h>
 
 #define DEBUG 0
 
@@ -16,16 +18,21 @@ c_Memory_t* create_c_memory_block(char* PID, unsigned short size, unsigned short
     block->size = size;
     block->offset = offset;
     block->next = NULL;
+    block->prev = NULL;
+    block->bin_next = NULL;
+    block->bin_prev = NULL;
     return block;
 }
 
 // Attempts to inject a process's memory into the system, may fail if not enough space
-// Returns TRUE/FALSE if successful or not
-int c_inject_mem(c_Memory_t* head, Process_t* process) {
+// Returns TRUE/FALSE if successful or not, the blocks looked at are stored in steps
+int c_inject_mem(c_Memory_t* head, Process_t* process, int* steps) {
     c_Memory_t* curr = head;
+    *steps = 0;
     // find the first big enough gap, first fit
     while (curr != NULL && (curr->PID != NULL || curr->size < process->memory) ) {
         curr = curr->next;
+        *steps += 1;
     }
     // no space for process
     if (curr == NULL) {
@@ -68,7 +75,9 @@ void c_eject_mem(c_Memory_t* memory, Process_t* process) {
         printf("Before merge\t");
         c_display_memory(memory);
     }
+    PROF_BEGIN(PROF_C_MERGE);
     c_merge_blocks(memory);
+    PROF_END(PROF_C_MERGE);
     
     if (DEBUG) {
         printf("After merge\t");
@@ -106,17 +115,29 @@ void c_merge_blocks(c_Memory_t* head) {
 
 // Calculates system memory usage for continuous memory
 double c_calc_mem_usage(c_Memory_t* head) {
-    double used = 0.0;
+    double used = 0.0, total = 0.0;
     c_Memory_t* curr = head;
     
     while (curr != NULL) {
         if (curr->PID != NULL) {
             used += curr->size;
         }
+        total += curr->size;
         curr = curr->next;
     }
 
-    return used / (double)SYSMEM;
+    return used / total;
+}
+
+// Counts the free blocks (holes) in continuous memory
+int c_cnt_holes(c_Memory_t* head) {
+    int holes = 0;
+    for (c_Memory_t* curr = head; curr != NULL; curr = curr->next) {
+        if (curr->PID == NULL) {
+            holes += 1;
+        }
+    }
+    return holes;
 }
 
 // For a given process, finds the offset in memory where the process lays, or -1 if its not in memory
@@ -155,70 +176,368 @@ void c_block_free(c_Memory_t* head) {
     }
 }
 
+// Fraction of free memory that is not in the largest hole, 0 when all free memory is one hole
+double c_ext_fragmentation(c_Memory_t* head) {
+    double free = 0, largest = 0;
+    for (c_Memory_t* curr = head; curr != NULL; curr = curr->next) {
+        if (curr->PID == NULL) {
+            free += curr->size;
+            if (curr->size > largest) {
+                largest = curr->size;
+            }
+        }
+    }
+    return free > 0 ? 1 - largest/free : 0;
+}
+
+// Records one allocation attempt and how many blocks it looked at
+void c_cnt_alloc(c_Alloc_stats_t* stats, int injected, int steps) {
+    stats->allocs += 1;
+    stats->steps += steps;
+    if (!injected) {
+        stats->failures += 1;
+    }
+    if (steps > stats->max_steps) {
+        stats->max_steps = steps;
+    }
+}
+
+// Displays allocation attempts, their cost in blocks looked at and the average external fragmentation
+void c_print_alloc_stats(c_Alloc_stats_t* stats) {
+    double allocs = stats->allocs ? stats->allocs : 1;
+    double samples = stats->frag_samples ? stats->frag_samples : 1;
+    printf("Allocations %d failed %d\n", stats->allocs, stats->failures);
+    printf("Allocation steps %.2f %d\n", stats->steps/allocs, stats->max_steps);
+    printf("External fragmentation %.2f\n", stats->frag/samples);
+}
+
+// Size class of a hole or request, the floor of its log2
+static int s_class(unsigned short size) {
+    int k = 0;
+    while (k+1 < S_BINS && (size >> (k+1)) != 0) {
+        k++;
+    }
+    return k;
+}
+
+// Puts a hole at the front of its size class bin
+static void s_bin_insert(s_Memory_t* memory, c_Memory_t* hole) {
+    int k = s_class(hole->size);
+    hole->bin_prev = NULL;
+    hole->bin_next = memory->bins[k];
+    if (hole->bin_next != NULL) {
+        hole->bin_next->bin_prev = hole;
+    }
+    memory->bins[k] = hole;
+    memory->nonempty |= 1u << k;
+}
+
+// Takes a hole out of its size class bin
+static void s_bin_remove(s_Memory_t* memory, c_Memory_t* hole) {
+    int k = s_class(hole->size);
+    if (hole->bin_prev != NULL) {
+        hole->bin_prev->bin_next = hole->bin_next;
+    } else {
+        memory->bins[k] = hole->bin_next;
+    }
+    if (hole->bin_next != NULL) {
+        hole->bin_next->bin_prev = hole->bin_prev;
+    }
+    if (memory->bins[k] == NULL) {
+        memory->nonempty &= ~(1u << k);
+    }
+    hole->bin_next = NULL;
+    hole->bin_prev = NULL;
+}
+
+// Sets up size class bins over a block list, either fresh or read back from a snapshot, and points each
+// process in memory at its block
+s_Memory_t* create_s_memory(c_Memory_t* head, Process_list_t* processes) {
+    s_Memory_t* memory = (s_Memory_t*) calloc(1, sizeof(s_Memory_t));
+    assert(memory);
+    memory->head = head;
+    c_Memory_t* prev = NULL;
+    for (c_Memory_t* curr = head; curr != NULL; curr = curr->next) {
+        curr->prev = prev;
+        prev = curr;
+        if (curr->PID == NULL) {
+            s_bin_insert(memory, curr);
+            continue;
+        }
+        for (int i=0; i<processes->total_processes; i++) {
+            if (processes->array[i].PID == curr->PID) {
+                processes->array[i].block = curr;
+            }
+        }
+    }
+    return memory;
+}
+
+// Injects a process into a hole from the size class bins, may fail if no hole is big enough. Only the bin
+// of the request's own class has to be searched, any hole in a higher class fits, and the bitmap finds the
+// first non empty one. Returns TRUE/FALSE if successful or not, the holes looked at are stored in steps
+int s_inject_mem(s_Memory_t* memory, Process_t* process, int* steps) {
+    int k = s_class(process->memory);
+    c_Memory_t* hole = memory->bins[k];
+    *steps = 0;
+    while (hole != NULL && hole->size < process->memory) {
+        hole = hole->bin_next;
+        *steps += 1;
+    }
+    if (hole == NULL) {
+        unsigned int larger = memory->nonempty & ~((2u << k) - 1);
+        if (larger == 0) {
+            return FALSE;
+        }
+        hole = memory->bins[__builtin_ctz(larger)];
+    }
+    *steps += 1;
+    s_bin_remove(memory, hole);
+
+    // the rest of the hole stays free, straight after the process
+    if (hole->size - process->memory != 0) {
+        c_Memory_t* rest = create_c_memory_block(NULL, hole->size - process->memory, hole->offset + process->memory);
+        rest->next = hole->next;
+        rest->prev = hole;
+        if (hole->next != NULL) {
+            hole->next->prev = rest;
+        }
+        hole->next = rest;
+        s_bin_insert(memory, rest);
+    }
+    hole->PID = process->PID;
+    hole->size = process->memory;
+    process->block = hole;
+    process->allocated = TRUE;
+    return TRUE;
+}
+
+// Ejects a process from segregated memory, merging the freed block with free neighbours only
+void s_eject_mem(s_Memory_t* memory, Process_t* process) {
+    c_Memory_t* block = (c_Memory_t*) process->block;
+    if (block == NULL) {
+        return;
+    }
+    PROF_BEGIN(PROF_C_MERGE);
+    block->PID = NULL;
+    process->block = NULL;
+    process->allocated = FALSE;
+
+    c_Memory_t* next = block->next;
+    if (next != NULL && next->PID == NULL) {
+        s_bin_remove(memory, next);
+        if (next->next != NULL) {
+            next->next->prev = block;
+        }
+        c_merge(block, next);
+    }
+    c_Memory_t* prev = block->prev;
+    if (prev != NULL && prev->PID == NULL) {
+        s_bin_remove(memory, prev);
+        if (block->next != NULL) {
+            block->next->prev = prev;
+        }
+        c_merge(prev, block);
+        block = prev;
+    }
+    s_bin_insert(memory, block);
+    PROF_END(PROF_C_MERGE);
+}
+
 // Creates the table used for paged/virtual memory
-f_Memory_t* create_f_memory_table(unsigned short total, int frame_size) {
-    f_Memory_t* memory = (f_Memory_t*) malloc(sizeof(f_Memory_t));
+f_Memory_t* create_f_memory_table(unsigned short total, int frame_size, int huge_frames) {
+    f_Memory_t* memory = (f_Memory_t*) calloc(1, sizeof(f_Memory_t));
     assert(memory);
     memory->total_mem = total;
     memory->num_frame = total/frame_size;
+    memory->huge_frames = huge_frames;
+    memory->nodes = 1;
     memory->frames = (char**) malloc(sizeof(char*)*memory->num_frame);
+    memory->refs = (int*) calloc(memory->num_frame, sizeof(int));
+    memory->share_group = (int*) malloc(sizeof(int)*memory->num_frame);
+    memory->share_page = (int*) malloc(sizeof(int)*memory->num_frame);
+    memory->share_bucket = (int*) malloc(sizeof(int)*memory->num_frame);
+    memory->share_next = (int*) malloc(sizeof(int)*memory->num_frame);
+    assert(memory->frames && memory->refs && memory->share_group && memory->share_page);
+    assert(memory->share_bucket && memory->share_next);
     // all intially free
     for (int i=0; i<memory->num_frame; i++) {
         memory->frames[i] = NULL;
+        memory->share_group[i] = -1;
+        memory->share_page[i] = -1;
+        memory->share_bucket[i] = -1;
+        memory->share_next[i] = -1;
     }
     return memory;
 }
 
 // Frees paged memory tables
 void f_table_free(f_Memory_t* memory) {
+    if (memory->pool != NULL) z_pool_free(memory->pool);
     free(memory->frames);
+    free(memory->refs);
+    free(memory->share_group);
+    free(memory->share_page);
+    free(memory->share_bucket);
+    free(memory->share_next);
     free(memory);
 }   
 
-// Returns the amount of free pages in memory
-int f_cnt_free_pages(f_Memory_t* table) {
-    int free = 0;
+// Hash bucket of a group's page in the shared frame index
+static int f_share_bucket(f_Memory_t* table, int group, int page) {
+    return ((unsigned int) group * 31 + page) % table->num_frame;
+}
+
+// Adds a frame that just became shared to the index
+static void f_index_shared(f_Memory_t* table, int frame) {
+    int bucket = f_share_bucket(table, table->share_group[frame], table->share_page[frame]);
+    table->share_next[frame] = table->share_bucket[bucket];
+    table->share_bucket[bucket] = frame;
+}
+
+// Takes a frame that is about to stop being shared out of the index
+static void f_unindex_shared(f_Memory_t* table, int frame) {
+    int* link = &table->share_bucket[f_share_bucket(table, table->share_group[frame], table->share_page[frame])];
+    while (*link != frame) {
+        link = &table->share_next[*link];
+    }
+    *link = table->share_next[frame];
+    table->share_next[frame] = -1;
+}
+
+// Rebuilds the frame counts and the shared frame index from the frame table, for a table read back from a file
+void f_recount(f_Memory_t* table) {
+    table->used_frames = 0;
+    table->extra_refs = 0;
+    for (int i=0; i<table->num_frame; i++) {
+        table->share_bucket[i] = -1;
+        table->share_next[i] = -1;
+    }
     for (int i=0; i<table->num_frame; i++) {
-        if (table->frames[i] == NULL) {
-            free += 1;
+        if (table->frames[i] != NULL) {
+            table->used_frames += 1;
+        }
+        if (table->share_group[i] != -1) {
+            table->extra_refs += table->refs[i] - 1;
+            f_index_shared(table, i);
+        }
+    }
+}
+
+// Counts the frames listed in an ejected memory array, which is ended by -2
+int f_cnt_listed(int* ejected_mem) {
+    int cnt = 0;
+    for (int i=0; ejected_mem[i] != -2; i++) {
+        if (ejected_mem[i] != -1) {
+            cnt += 1;
+        }
+    }
+    return cnt;
+}
+
+// Checks if a page table entry points at a frame shared by a sharing group
+static int f_is_shared(f_Memory_t* table, int frame) {
+    return frame != -1 && table->share_group[frame] != -1;
+}
+
+// Returns the first page from 'page' on that is not already mapped onto a shared frame
+static int f_skip_shared(f_Memory_t* table, Process_t* process, int page) {
+    while (page < process->pages && f_is_shared(table, process->page_table[page])) {
+        page++;
+    }
+    return page;
+}
+
+// Gives a free frame to a process
+static void f_take_frame(f_Memory_t* table, int frame, Process_t* process) {
+    table->frames[frame] = process->PID;
+    table->used_frames += 1;
+}
+
+// Drops a page table's hold on a frame, the frame is only freed once no sharer maps it. Returns if it was freed
+static int f_release_frame(f_Memory_t* table, int frame) {
+    if (table->share_group[frame] != -1) {
+        if (--table->refs[frame] > 0) {
+            table->extra_refs -= 1;
+            return FALSE;
         }
+        f_unindex_shared(table, frame);
     }
+    table->frames[frame] = NULL;
+    table->used_frames -= 1;
+    table->share_group[frame] = -1;
+    table->share_page[frame] = -1;
+    return TRUE;
+}
+
+// Marks the shared pages a process just loaded into fresh frames, so the rest of its group can map them
+static void f_tag_shared(f_Memory_t* table, Process_t* process) {
+    for (int i=process->written; i<process->shared; i++) {
+        int frame = process->page_table[i];
+        if (frame != -1 && table->share_group[frame] == -1) {
+            table->share_group[frame] = process->group;
+            table->share_page[frame] = i;
+            table->refs[frame] = 1;
+            f_index_shared(table, frame);
+        }
+    }
+}
+
+// Returns the amount of free pages in memory
+int f_cnt_free_pages(f_Memory_t* table) {
+    PROF_BEGIN(PROF_F_FREE_PAGES);
+    int free = table->num_frame - table->used_frames;
+    PROF_END(PROF_F_FREE_PAGES);
     return free;
 }
 
-// Injects the given processes into memory, freeing pages if required
-void f_inject_mem(int cycle, f_Memory_t* table, Process_t* process, queue_t* queue) {
-    // array to store all ejected pages so it can be accurately printed later
-    int ejected_mem[SYSMEM/PAGESIZE + 1];
+// Injects the given processes into memory, freeing pages if required. The freed frames are stored in
+// ejected_mem (num_frame + 1 long) so they can be reported, returns how many frames were freed
+int f_inject_mem(int* ejected_mem, f_Memory_t* table, Process_t* process, queue_t* queue) {
     int i;
     // -1 meaning not used, -2 meaning end of array
-    for (i=0; i<SYSMEM/PAGESIZE; i++) {
+    for (i=0; i<table->num_frame; i++) {
         ejected_mem[i] = -1;
     }
     ejected_mem[i] = -2;
     
+    // pages the rest of the group already loaded need no frame of their own
+    if (table->sharing) {
+        f_attach_shared(table, process);
+    }
+
     // free pages if not enough for this process
     int space;
-    while ((space = f_cnt_free_pages(table)) < process->pages) {
+    while ((space = f_cnt_free_pages(table)) < process->pages - v_cnt_allocated(process)) {
         f_free_mem(ejected_mem, table, queue); 
     }
 
-    if (ejected_mem[0] != -1) print_evicted_message(cycle, ejected_mem, SYSMEM/PAGESIZE);
+    int ejected = f_cnt_listed(ejected_mem);
 
-    // inserts process into memory
-    int k=0;
-    for (int i=0; i<table->num_frame; i++) {
-        if (table->frames[i] == NULL) {
-            table->frames[i] = process->PID; 
-            process->page_table[k++] = i; // page 'k' is in index 'i' frame  
+    if (table->nodes > 1) {
+        f_map_numa(table, process);
+    } else if (table->huge_frames) {
+        f_map_huge(table, process);
+    } else {
+        // inserts process into memory
+        int k = f_skip_shared(table, process, 0);
+        for (int i=0; i<table->num_frame && k < process->pages; i++) {
+            if (table->frames[i] == NULL) {
+                f_take_frame(table, i, process);
+                process->page_table[k] = i; // page 'k' is in index 'i' frame  
+                k = f_skip_shared(table, process, k+1);
+                table->faults += 1;
+            }
         }
         if (k >= process->pages) {
             // all process pages allocated
             process->allocated = TRUE;
-            break;
         }
     }
-    
+    if (table->sharing) {
+        f_tag_shared(table, process);
+    }
+    return ejected;
 }
 
 // frees memory based on least recent process ideal 
@@ -237,41 +556,28 @@ void f_free_mem(int* ejected_mem, f_Memory_t* table, queue_t* queue) {
     f_eject_mem(ejected_mem, table, least_recent_process_allocated);
 }
 
-// Ejects the given process from paged memory
+// Ejects the given process from paged memory, after it finished or to make space. The frames freed are listed
+// in ejected_mem, which is ended by -2, a frame other sharers still map is let go of but stays and is not listed
 void f_eject_mem(int* ejected_mem, f_Memory_t* table, Process_t* process) {
     assert(process != NULL);
     int j = 0; // ejected mem offset
-    int l = 0; // process mem offset
-
-    // two cases, either ejecting after finishing or ejecting to make space 
-    // ejecting after process, no need to have an ejected_mem array
-    if (ejected_mem == NULL) {
-        for (int i=0; i+l<process->pages; i++) {
-            while (process->page_table[i+l] == -1) {
-            l++;
-            if (i+l >= process->pages) return; 
-        }
-            table->frames[process->page_table[i+l]] = NULL; // clear memory
-            process->page_table[i+l] = -1;
-        }
-        process->allocated = FALSE;
-        return;
-    }
-    // ejecting to make space, using j to maintain correct position in ejected_mem
-    for (int i=0; i+l<process->pages; i++) {       
-        while (process->page_table[i+l] == -1) {
-            l++;
-            if (i+l > process->pages) return; 
+    if (table->pool != NULL) z_forget(table->pool, process);
+    for (int i=0; i<process->pages; i++) {
+        int frame = process->page_table[i];
+        if (frame == -1) {
+            continue;
         }
-        table->frames[process->page_table[i+l]] = NULL; // clear memory
-        while (ejected_mem[i+j] != -1 && ejected_mem[i+j] != -2) {
+        // find room in the list first, so no frame is freed without being listed
+        while (ejected_mem[j] != -1 && ejected_mem[j] != -2) {
             j++;
         }
-        if (ejected_mem[i+j] == -2) {
+        if (ejected_mem[j] == -2) {
             break;
         }
-        ejected_mem[i+j] = process->page_table[i+l];
-        process->page_table[i+l] = -1;
+        if (f_release_frame(table, frame)) {
+            ejected_mem[j] = frame;
+        }
+        process->page_table[i] = -1;
     }
     process->allocated = FALSE;
 }
@@ -287,8 +593,41 @@ double f_mem_usage(f_Memory_t* table) {
     return used/(double)table->num_frame;
 }
 
+// Prints the used frames of a page table as runs, each frame after the one before it in the list, as ranges
+// like [0-255,300-555], a lone frame is printed on its own
+static void f_print_frame_ranges(int* page_table, int pages) {
+    int first = -1, last = -1;
+    char sep = '[';
+    for (int i=0; i<pages; i++) {
+        if (page_table[i] == -1) {
+            continue;
+        }
+        if (first != -1 && page_table[i] == last + 1) {
+            last = page_table[i];
+            continue;
+        }
+        if (first != -1) {
+            if (first == last) printf("%c%d", sep, first);
+            else printf("%c%d-%d", sep, first, last);
+            sep = ',';
+        }
+        first = last = page_table[i];
+    }
+    if (first == -1) {
+        printf("[]\n");
+    } else if (first == last) {
+        printf("%c%d]\n", sep, first);
+    } else {
+        printf("%c%d-%d]\n", sep, first, last);
+    }
+}
+
 // Prints out a formatted array, used to print out memory frames
-void f_print_mem_frames(int* page_table, int pages) {
+void f_print_mem_frames(int* page_table, int pages, int compact) {
+    if (compact) {
+        f_print_frame_ranges(page_table, pages);
+        return;
+    }
     // skip all -1 values, they are not used frames
     int i=0;
     while (page_table[i] == -1) {
@@ -317,10 +656,19 @@ int v_cnt_allocated(Process_t* process) {
     return cnt;
 }
 
-// Injects a process into virtual memory, freeing memory if required
-void v_inject_mem(Process_t* process, f_Memory_t* table, queue_t* queue, int cycle) {
+// Injects a process into virtual memory, freeing memory if required. The freed frames are stored in
+// ejected_mem (REQ_PAGES + 1 long) so they can be reported, returns how many frames were freed
+int v_inject_mem(int* ejected_mem, Process_t* process, f_Memory_t* table, queue_t* queue) {
     // will ever only eject the minimum required pages (from here atleast)
-    int ejected_mem[REQ_PAGES + 1] = {-1, -1, -1, -1, -2};
+    for (int i=0; i<REQ_PAGES; i++) {
+        ejected_mem[i] = -1;
+    }
+    ejected_mem[REQ_PAGES] = -2;
+
+    // pages the rest of the group already loaded need no frame of their own
+    if (table->sharing) {
+        f_attach_shared(table, process);
+    }
 
     // if we dont have enough free pages
     int c;
@@ -329,24 +677,35 @@ void v_inject_mem(Process_t* process, f_Memory_t* table, queue_t* queue, int cyc
         if (DEBUG) printf("required = %d | %d ", c, free);
         v_free_mem(ejected_mem, table, queue, c-free);
     } 
-    if (ejected_mem[0] != -1) print_evicted_message(cycle, ejected_mem, REQ_PAGES);
+    int ejected = f_cnt_listed(ejected_mem);
     
     if (DEBUG) printf("DEBUG ");
-    if (DEBUG) print_evicted_message(cycle, ejected_mem, REQ_PAGES);
-  
-    int k=0;
-    for (int i=0; i<table->num_frame; i++) {
+    if (DEBUG) print_evicted_message(0, ejected_mem, REQ_PAGES, FALSE);
+
+    if (table->nodes > 1) {
+        f_map_numa(table, process);
+    } else if (table->huge_frames) {
+        f_map_huge(table, process);
+    } else {
+        int k = f_skip_shared(table, process, 0);
         // go until we have fill all memory or put all process memory in 
-        if (table->frames[i] == NULL) {
-            table->frames[i] = process->PID; // should work?
-            process->page_table[k++] = i; // page 'k' is in index 'i' frame  
-        }
-        if (k >= process->pages) {
-            // all process pages allocated
-            break;
+        for (int i=0; i<table->num_frame && k < process->pages; i++) {
+            if (table->frames[i] == NULL) {
+                f_take_frame(table, i, process);
+                process->page_table[k] = i; // page 'k' is in index 'i' frame  
+                k = f_skip_shared(table, process, k+1);
+                table->faults += 1;
+            }
         }
+        process->allocated = TRUE;
     }
-    process->allocated = TRUE;
+    if (table->sharing) {
+        f_tag_shared(table, process);
+    }
+    if (table->pool != NULL) {
+        z_cnt_reload(table->pool, process);
+    }
+    return ejected;
 }
 
 // Finds the least recent allocated process to eject required memory
@@ -384,20 +743,484 @@ void v_eject_mem(int* ejected_mem, Process_t* process, f_Memory_t* table, int re
         }
         if(DEBUG) printf("\n");
         
-        while (process->page_table[i+l] == -1) l++;
-        
-        if (DEBUG) printf("process->page_table[i+l] = %d table->frames[process->page_table[i+l]] = %s before ejection\n", process->page_table[i+l], table->frames[process->page_table[i+l]]);           
+        while (i+l < process->pages && process->page_table[i+l] == -1) l++;
+        if (i+l >= process->pages) break;
 
-        table->frames[process->page_table[i+l]] = NULL; // clear memory
+        // find room in the list first, so no frame is freed without being listed
         while (ejected_mem[i+j] != -1 && ejected_mem[i+j] != -2) {
             j++;
         }
         if (ejected_mem[i+j] == -2) {
             break;
         }
-        ejected_mem[i+j] = process->page_table[i+l];
+
+        // evicting part of a huge frame splits it back into small frames
+        if (table->huge_frames > 1 && (i+l) / table->huge_frames < process->pages / table->huge_frames
+                && f_is_huge_mapped(table, process, (i+l) / table->huge_frames)) {
+            table->demotions += 1;
+        }
+        
+        if (DEBUG) printf("process->page_table[i+l] = %d table->frames[process->page_table[i+l]] = %s before ejection\n", process->page_table[i+l], table->frames[process->page_table[i+l]]);           
+
+        // a frame other sharers still map stays, only this page table lets go of it
+        if (f_release_frame(table, process->page_table[i+l])) {
+            if (table->pool != NULL) z_store(table->pool, process, i+l);
+            ejected_mem[i+j] = process->page_table[i+l];
+        }
         process->page_table[i+l] = -1;
     }
 
     if (v_cnt_allocated(process) == 0) process->allocated = FALSE;
-}
\ No newline at end of file
+}
+
+// Finds a free run of 'len' frames starting on a multiple of 'len', returns the first frame or -1 if none
+int f_find_free_run(f_Memory_t* table, int len) {
+    for (int start=0; start+len<=table->num_frame; start+=len) {
+        int i = 0;
+        while (i < len && table->frames[start+i] == NULL) {
+            i++;
+        }
+        if (i == len) {
+            return start;
+        }
+    }
+    return -1;
+}
+
+// Checks if a group of pages (of huge frame size) is mapped onto one aligned huge frame
+int f_is_huge_mapped(f_Memory_t* table, Process_t* process, int group) {
+    int h = table->huge_frames;
+    int first = process->page_table[group*h];
+    if (first == -1 || first % h != 0) {
+        return FALSE;
+    }
+    for (int i=1; i<h; i++) {
+        if (process->page_table[group*h + i] != first + i) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// Maps as many unloaded pages of a process as fit. Whole groups of pages go into aligned huge frames, groups
+// that cannot find one are demoted to small frames, and groups left in small frames are promoted when a huge
+// frame frees up. Processes smaller than a huge frame only ever get small frames. A demotion is counted once,
+// when a group with nothing resident is loaded into small frames, a group already in them is not demoted again.
+void f_map_huge(f_Memory_t* table, Process_t* process) {
+    int h = table->huge_frames;
+    int groups = process->pages/h;
+
+    // groups with no page resident before this load
+    int empty[groups > 0 ? groups : 1];
+    for (int g=0; g<groups; g++) {
+        empty[g] = TRUE;
+        for (int i=g*h; i<(g+1)*h; i++) {
+            if (process->page_table[i] != -1) {
+                empty[g] = FALSE;
+                break;
+            }
+        }
+    }
+
+    for (int g=0; g<groups; g++) {
+        if (f_is_huge_mapped(table, process, g)) {
+            continue;
+        }
+        // a group holding frames shared with other processes stays in small frames
+        int shared = FALSE;
+        for (int i=g*h; i<(g+1)*h; i++) {
+            shared |= f_is_shared(table, process->page_table[i]);
+        }
+        if (shared) {
+            continue;
+        }
+        int start = f_find_free_run(table, h);
+        if (start == -1) {
+            continue;
+        }
+        // group was partly loaded in small frames, collapse it into the huge frame
+        int loaded = 0;
+        for (int i=g*h; i<(g+1)*h; i++) {
+            if (process->page_table[i] != -1) {
+                f_release_frame(table, process->page_table[i]);
+                loaded += 1;
+            }
+            f_take_frame(table, start + i - g*h, process);
+            process->page_table[i] = start + i - g*h;
+        }
+        if (loaded > 0 && h > 1) table->promotions += 1;
+        table->faults += 1;
+    }
+
+    // everything else goes into small frames, lowest first
+    int frame = 0;
+    for (int i=0; i<process->pages; i++) {
+        if (process->page_table[i] != -1) {
+            continue;
+        }
+        while (frame < table->num_frame && table->frames[frame] != NULL) {
+            frame++;
+        }
+        if (frame == table->num_frame) {
+            break;
+        }
+        f_take_frame(table, frame, process);
+        process->page_table[i] = frame;
+        table->faults += 1;
+    }
+    for (int g=0; h>1 && g<groups; g++) {
+        if (empty[g] && process->page_table[g*h] != -1 && !f_is_huge_mapped(table, process, g)) {
+            table->demotions += 1;
+        }
+    }
+    process->allocated = TRUE;
+}
+
+// Counts the page table entries a process needs, a huge frame only needs one entry
+int f_cnt_pt_entries(f_Memory_t* table, Process_t* process) {
+    int h = table->huge_frames;
+    int entries = v_cnt_allocated(process);
+    for (int g=0; h>1 && g<process->pages/h; g++) {
+        if (f_is_huge_mapped(table, process, g)) {
+            entries -= h - 1;
+        }
+    }
+    return entries;
+}
+
+// Records an EVICTED message listing the given number of frames
+void f_cnt_eviction(f_Memory_t* table, int frames) {
+    table->evict_msgs += 1;
+    table->evicted_frames += frames;
+}
+
+// Records the page table size of a process starting on the CPU
+void f_cnt_dispatch(f_Memory_t* table, Process_t* process) {
+    table->dispatches += 1;
+    table->small_entries += v_cnt_allocated(process);
+    table->pt_entries += table->huge_frames ? f_cnt_pt_entries(table, process) : v_cnt_allocated(process);
+}
+
+// Displays page table, fault and eviction counts, used to compare huge frame sizes
+void f_print_paging_stats(f_Memory_t* table) {
+    double dispatches = table->dispatches ? table->dispatches : 1;
+    printf("Huge frame size %d\n", table->huge_frames*PAGESIZE);
+    printf("Page table entries %.2f %.2f\n", table->pt_entries/dispatches, table->small_entries/dispatches);
+    printf("Page faults %d\n", table->faults);
+    printf("Evictions %d %d\n", table->evict_msgs, table->evicted_frames);
+    printf("Huge promotions %d demotions %d\n", table->promotions, table->demotions);
+}
+
+// Checks if starting the given process would force other processes out of memory
+int f_needs_eviction(f_Memory_t* table, Process_t* process, int alloc_mode) {
+    if (alloc_mode == VIRTUAL) {
+        int missing = REQ_PAGES - v_cnt_allocated(process);
+        return missing > 0 && missing > f_cnt_free_pages(table);
+    }
+    return process->allocated == FALSE && f_cnt_free_pages(table) < process->pages;
+}
+
+// Memory aware scheduling, if the queue head would evict someone to run, looks within the next 'window'
+// processes for one that can run without evicting and moves it to the top of the queue instead. A process
+// can only be passed over 'window' times in a row, so everything still gets to run. The process that just
+// ran, 'ran', is never picked, its quantum is over as in plain RR.
+void f_pick_resident(f_Memory_t* table, queue_t* queue, int window, int alloc_mode, Process_t* ran) {
+    Process_t* head = queue->head->process;
+    if (head->skips >= window || !f_needs_eviction(table, head, alloc_mode)) {
+        head->skips = 0;
+        return;
+    }
+    node_t* prev = queue->head;
+    for (int i=0; i<window && prev->next != NULL; i++) {
+        if (prev->next->process != ran && !f_needs_eviction(table, prev->next->process, alloc_mode)) {
+            promote(queue, prev);
+            head->skips += 1;
+            table->bypasses += 1;
+            return;
+        }
+        prev = prev->next;
+    }
+}
+
+// Splits the frame table into NUMA nodes of equal size
+void f_set_numa(f_Memory_t* table, int nodes, int policy) {
+    if (nodes < 1) nodes = 1;
+    if (nodes > MAX_NODES) nodes = MAX_NODES;
+    // every node owns at least one frame
+    if (nodes > table->num_frame) nodes = table->num_frame;
+    table->nodes = nodes;
+    table->numa_policy = policy;
+}
+
+// Returns the node a frame belongs to
+int f_node_of(f_Memory_t* table, int frame) {
+    int node = frame / (table->num_frame / table->nodes);
+    return node < table->nodes ? node : table->nodes - 1;
+}
+
+// Finds a free frame on the given node, moving on to the following nodes if it is full, or -1 if memory is full.
+// cursor holds where the last search on each node stopped, so mapping a whole process stays linear.
+static int f_find_free_frame(f_Memory_t* table, int node, int* cursor) {
+    int per_node = table->num_frame / table->nodes;
+    for (int k=0; k<table->nodes; k++) {
+        int n = (node + k) % table->nodes;
+        int end = n == table->nodes - 1 ? table->num_frame : (n+1)*per_node;
+        if (cursor[n] < n*per_node) cursor[n] = n*per_node;
+        while (cursor[n] < end && table->frames[cursor[n]] != NULL) {
+            cursor[n]++;
+        }
+        if (cursor[n] < end) {
+            return cursor[n];
+        }
+    }
+    return -1;
+}
+
+// Maps as many unloaded pages of a process as fit, placing each by the NUMA policy. Processes get a home node
+// round robin the first time they are loaded.
+void f_map_numa(f_Memory_t* table, Process_t* process) {
+    int cursor[MAX_NODES] = {0};
+    if (process->home_node == -1) {
+        process->home_node = table->next_home++ % table->nodes;
+    }
+    for (int i=0; i<process->pages; i++) {
+        if (process->page_table[i] != -1) {
+            continue;
+        }
+        int node = process->home_node;
+        if (table->numa_policy == NUMA_INTERLEAVE) {
+            node = (process->home_node + i) % table->nodes;
+        } else if (table->numa_policy == NUMA_SPILL) {
+            node = 0;
+        }
+        int frame = f_find_free_frame(table, node, cursor);
+        if (frame == -1) {
+            break;
+        }
+        f_take_frame(table, frame, process);
+        process->page_table[i] = frame;
+        table->faults += 1;
+        if (f_node_of(table, frame) == process->home_node) {
+            table->node_stats[f_node_of(table, frame)].local += 1;
+        } else {
+            table->node_stats[f_node_of(table, frame)].remote += 1;
+        }
+    }
+    process->allocated = TRUE;
+
+    int used[MAX_NODES] = {0};
+    for (int i=0; i<table->num_frame; i++) {
+        if (table->frames[i] != NULL) {
+            used[f_node_of(table, i)] += 1;
+        }
+    }
+    for (int n=0; n<table->nodes; n++) {
+        if (used[n] > table->node_stats[n].peak) {
+            table->node_stats[n].peak = used[n];
+        }
+    }
+}
+
+// Counts the loaded pages of a process that sit on a node other than its home node
+int f_remote_pages(f_Memory_t* table, Process_t* process) {
+    int remote = 0;
+    for (int i=0; i<process->pages; i++) {
+        if (process->page_table[i] != -1 && f_node_of(table, process->page_table[i]) != process->home_node) {
+            remote += 1;
+        }
+    }
+    return remote;
+}
+
+// Displays the usage of each NUMA node and the total remote access penalty
+void f_print_node_stats(f_Memory_t* table) {
+    for (int n=0; n<table->nodes; n++) {
+        Node_stats_t* node = &table->node_stats[n];
+        printf("Node %d peak-frames=%d local-pages=%ld remote-pages=%ld\n", n, node->peak, node->local, node->remote);
+    }
+    printf("Remote penalty %ld\n", table->remote_penalty);
+}
+
+// Maps the process's shared pages onto frames its group already has loaded, these cost no fault
+void f_attach_shared(f_Memory_t* table, Process_t* process) {
+    for (int i=process->written; i<process->shared; i++) {
+        if (process->page_table[i] != -1) {
+            continue;
+        }
+        // a page reloaded by sharers at different times can be in more than one frame, the lowest is used
+        int frame = -1;
+        for (int f = table->share_bucket[f_share_bucket(table, process->group, i)]; f != -1; f = table->share_next[f]) {
+            if (table->share_group[f] == process->group && table->share_page[f] == i && (frame == -1 || f < frame)) {
+                frame = f;
+            }
+        }
+        if (frame != -1) {
+            process->page_table[i] = frame;
+            table->refs[frame] += 1;
+            table->extra_refs += 1;
+            table->attaches += 1;
+        }
+    }
+}
+
+// The process writes to 'percent' of the shared pages it has not written yet, in page order. A page other
+// sharers still map is copied into a free frame first, the last sharer just keeps the frame as private.
+void f_cow_write(f_Memory_t* table, Process_t* process, int percent) {
+    int writes = ceil((process->shared - process->written) * percent / 100.0);
+    for (; writes > 0 && process->written < process->shared; writes--) {
+        int frame = process->page_table[process->written];
+        if (frame != -1 && table->refs[frame] > 1) {
+            int copy = f_find_free_run(table, 1);
+            if (copy == -1) {
+                // no room for the copy, try again next time the process runs
+                table->cow_deferred += 1;
+                return;
+            }
+            table->refs[frame] -= 1;
+            table->extra_refs -= 1;
+            f_take_frame(table, copy, process);
+            process->page_table[process->written] = copy;
+            table->cow_copies += 1;
+        } else if (frame != -1 && table->share_group[frame] != -1) {
+            f_unindex_shared(table, frame);
+            table->share_group[frame] = -1;
+            table->share_page[frame] = -1;
+        }
+        // an unloaded page is loaded private from now on
+        process->written += 1;
+    }
+}
+
+// Records the frames in use against what they would be if no page was shared
+void f_cnt_sharing(f_Memory_t* table) {
+    int used = table->used_frames;
+    // every page table entry onto a shared frame would need a frame of its own, the pool's frames hold no page
+    int private_pages = used - (table->pool != NULL ? table->pool->reserved : 0) + table->extra_refs;
+    if (used > table->peak_frames) {
+        table->peak_frames = used;
+    }
+    if (private_pages > table->peak_private) {
+        table->peak_private = private_pages;
+    }
+}
+
+// Displays how much memory sharing saved and how much copy on write cost
+void f_print_sharing_stats(f_Memory_t* table) {
+    printf("Shared pages attached %ld\n", table->attaches);
+    printf("COW copies %d deferred %d\n", table->cow_copies, table->cow_deferred);
+    printf("Peak frames %d private %d\n", table->peak_frames, table->peak_private);
+}
+
+// owner of the frames reserved for the swap pool
+static char z_owner[] = "ZSWAP";
+
+// Sets aside 'percent' of the frames as a compressed swap pool holding 'ratio' pages per frame
+z_Pool_t* z_create_pool(f_Memory_t* table, int percent, double ratio, double pool_latency, double disk_latency) {
+    z_Pool_t* pool = (z_Pool_t*) calloc(1, sizeof(z_Pool_t));
+    assert(pool);
+    pool->reserved = percent > 0 ? table->num_frame * percent / 100 : 0;
+    // a process still needs room for the pages it must have loaded to run
+    if (pool->reserved > table->num_frame - REQ_PAGES) {
+        pool->reserved = table->num_frame - REQ_PAGES;
+    }
+    pool->capacity = pool->reserved * ratio;
+    pool->pool_latency = pool_latency;
+    pool->disk_latency = disk_latency;
+    pool->entries = (z_Entry_t*) malloc(sizeof(z_Entry_t)*(pool->capacity + 1));
+    assert(pool->entries);
+    table->pool = pool;
+    z_reserve(table);
+    return pool;
+}
+
+// Marks the pool's frames as taken, so processes are never loaded into them
+void z_reserve(f_Memory_t* table) {
+    for (int i=table->num_frame - table->pool->reserved; i<table->num_frame; i++) {
+        if (table->frames[i] == NULL) table->used_frames += 1;
+        table->frames[i] = z_owner;
+    }
+}
+
+// Takes the entry at 'index' out of the pool
+static void z_remove(z_Pool_t* pool, int index) {
+    memmove(&pool->entries[index], &pool->entries[index+1], sizeof(z_Entry_t)*(pool->used - index - 1));
+    pool->used -= 1;
+}
+
+// Compresses an evicted page into the pool, pushing the oldest page out to backing store if the pool is full
+void z_store(z_Pool_t* pool, Process_t* process, int page) {
+    if (process->swap == NULL) {
+        process->swap = (int*) calloc(process->pages, sizeof(int));
+        assert(process->swap);
+    }
+    if (pool->capacity == 0) {
+        process->swap[page] = Z_DISK;
+        return;
+    }
+    if (pool->used == pool->capacity) {
+        z_Entry_t* oldest = &pool->entries[0];
+        oldest->process->swap[oldest->page] = Z_DISK;
+        z_remove(pool, 0);
+        pool->writebacks += 1;
+    }
+    pool->entries[pool->used].process = process;
+    pool->entries[pool->used].page = page;
+    pool->used += 1;
+    process->swap[page] = Z_POOL;
+    pool->stores += 1;
+}
+
+// Counts the evicted pages of a process that were just loaded back, adding up how long they took to reload.
+// Loading a page for the first time is not a reload and costs nothing, as without the swap tier.
+void z_cnt_reload(z_Pool_t* pool, Process_t* process) {
+    if (process->swap == NULL) {
+        return;
+    }
+    for (int i=0; i<process->pages; i++) {
+        if (process->swap[i] == Z_NONE || process->page_table[i] == -1) {
+            continue;
+        }
+        if (process->swap[i] == Z_POOL) {
+            for (int k=0; k<pool->used; k++) {
+                if (pool->entries[k].process == process && pool->entries[k].page == i) {
+                    z_remove(pool, k);
+                    break;
+                }
+            }
+            pool->hits += 1;
+            pool->pending += pool->pool_latency;
+        } else {
+            pool->misses += 1;
+            pool->pending += pool->disk_latency;
+        }
+        process->swap[i] = Z_NONE;
+    }
+}
+
+// Drops the pages of a finished process from the pool
+void z_forget(z_Pool_t* pool, Process_t* process) {
+    if (process->swap == NULL) {
+        return;
+    }
+    for (int k=pool->used-1; k>=0; k--) {
+        if (pool->entries[k].process == process) {
+            z_remove(pool, k);
+        }
+    }
+    memset(process->swap, 0, sizeof(int)*process->pages);
+}
+
+// Displays how much the pool held and how often reloads were served from it
+void z_print_stats(z_Pool_t* pool) {
+    long reloads = pool->hits + pool->misses;
+    printf("Swap pool frames %d pages %d\n", pool->reserved, pool->capacity);
+    printf("Swap stores %ld writebacks %ld\n", pool->stores, pool->writebacks);
+    printf("Swap reloads %ld pool-hits %ld hit-rate %.2f\n", reloads, pool->hits,
+            reloads ? (double)pool->hits/reloads : 0);
+    printf("Swap latency %ld\n", pool->charged);
+}
+
+void z_pool_free(z_Pool_t* pool) {
+    free(pool->entries);
+    free(pool);
+}
@@ -8,10 +8,53 @@
 #define FIRSTFIT 3
 #define PAGED 4
 #define VIRTUAL 5
+#define SEGREGATED 6
 
 #define SYSMEM (unsigned short)2048
 #define PAGESIZE 4
 #define REQ_PAGES 4
+#define S_BINS 16   // size classes for segregated memory, bin k holds holes of 2^k to 2^(k+1)-1 KBs
+
+// NUMA placement policies for paged/virtual memory split over several nodes
+#define NUMA_LOCAL 0        // home node first, then the following nodes
+#define NUMA_INTERLEAVE 1   // pages spread round robin over the nodes, starting at the home node
+#define NUMA_SPILL 2        // fill node 0, then spill into node 1 and so on, ignoring the home node
+#define MAX_NODES 16
+
+// Where an evicted page of a process is, for the compressed swap tier
+#define Z_NONE 0    // loaded, or never evicted
+#define Z_POOL 1    // compressed in the swap pool
+#define Z_DISK 2    // on backing store
+
+// A compressed page in the swap pool
+typedef struct {
+    Process_t* process;
+    int page;
+} z_Entry_t;
+
+// Compressed swap tier for virtual memory. It takes the last frames of the frame table, and pages evicted
+// from memory are kept there compressed until the pool is full, then the oldest go on to backing store.
+typedef struct {
+    int reserved;           // frames set aside for the pool, the last ones in the frame table
+    int capacity;           // compressed pages the reserved frames hold
+    double pool_latency;    // cycles to reload a page from the pool
+    double disk_latency;    // cycles to reload a page from backing store
+    z_Entry_t* entries;     // pages in the pool, oldest first
+    int used;
+    double pending;         // reload latency not yet charged to the process being loaded
+    long stores;            // pages put in the pool
+    long writebacks;        // pages pushed out of the pool to backing store
+    long hits;              // reloads served by the pool
+    long misses;            // reloads from backing store
+    long charged;           // cycles processes stalled reloading pages
+} z_Pool_t;
+
+// Per node counters for NUMA memory
+typedef struct {
+    int peak;           // most frames in use at once
+    long local;         // pages placed here for processes homed on this node
+    long remote;        // pages placed here for processes homed on another node
+} Node_stats_t;
 
 // Struct for continuous (firstfit) memory
 typedef struct c_Memory {
@@ -19,35 +62,120 @@ typedef struct c_Memory {
     char* PID;             // ID of process if block is allocated
     unsigned short size;   // in KBs
     unsigned short offset; // position in memory
+    struct c_Memory* prev; // block before this one, segregated memory only
+    struct c_Memory* bin_next; // other holes in the same size class, segregated memory only
+    struct c_Memory* bin_prev;
 } c_Memory_t;
 
+// Size class bins over the continuous block list, so a fitting hole is found without walking the list
+typedef struct {
+    c_Memory_t* head;           // address ordered block list, laid out the same as for first-fit
+    c_Memory_t* bins[S_BINS];   // free holes of each size class, most recently freed first
+    unsigned int nonempty;      // bit k is set while bins[k] holds a hole
+} s_Memory_t;
+
+// Allocation counters for continuous memory, used to compare first-fit with segregated fit
+typedef struct {
+    int allocs;         // allocation attempts
+    int failures;       // attempts that found no hole big enough
+    long steps;         // blocks looked at over all attempts
+    int max_steps;      // most blocks looked at by one attempt
+    double frag;        // external fragmentation summed over the attempts it was sampled at
+    int frag_samples;
+} c_Alloc_stats_t;
+
 // Struct for paged and virtual memory
 typedef struct f_Memory {
     char** frames;      // array showing what process in is a given frame (or free)
     int num_frame;      // total num of frames
     int total_mem;      // how much memory in total, in KBs
+    int huge_frames;    // small frames making up one huge frame, 0 if huge pages are disabled
+    int faults;         // page loads, a whole huge frame counts as one load
+    int promotions;     // page groups collapsed from small frames into a huge frame
+    int demotions;      // page groups loaded into small frames for want of a huge frame, or split by eviction
+    int evict_msgs;     // EVICTED lines printed
+    int evicted_frames; // frames listed over all EVICTED lines
+    int dispatches;     // times a process was started on the CPU
+    long pt_entries;    // page table entries in use, summed over every dispatch
+    long small_entries; // the same sum if every page was mapped by a small frame
+    int bypasses;       // dispatches where a process in memory was run ahead of the queue head
+    int nodes;          // NUMA nodes the frames are split over, each owns a contiguous slice, 1 for flat memory
+    int numa_policy;    // where pages are placed when there is more than one node
+    int next_home;      // home node given to the next process, handed out round robin
+    long remote_penalty;// cycles processes stalled loading pages on another node
+    Node_stats_t node_stats[MAX_NODES];
+    int sharing;        // boolean value if processes share pages, shared frames are then reference counted
+    int* refs;          // page tables mapping each shared frame
+    int* share_group;   // sharing group of the page in each frame, -1 for a private frame
+    int* share_page;    // which of the group's pages is in each shared frame
+    int* share_bucket;  // first shared frame of each hash bucket of (group, page), -1 if the bucket is empty
+    int* share_next;    // next shared frame in the same bucket, -1 at the end
+    int used_frames;    // frames not free, kept up to date as frames are taken and freed
+    int extra_refs;     // page tables mapping a shared frame beyond the first, kept up to date with refs
+    long attaches;      // shared pages mapped onto a frame another process had already loaded
+    int cow_copies;     // shared pages copied to a private frame on a write
+    int cow_deferred;   // writes that found no free frame to copy into, the page stays shared for now
+    int peak_frames;    // most frames in use at once
+    int peak_private;   // most frames in use at once if every page was private
+    z_Pool_t* pool;     // compressed swap tier, NULL if evicted pages are dropped
 } f_Memory_t;
 
 c_Memory_t* create_c_memory_block(char* PID, unsigned short size, unsigned short offset);
-int c_inject_mem(c_Memory_t* head, Process_t* process);
+int c_inject_mem(c_Memory_t* head, Process_t* process, int* steps);
 void c_eject_mem(c_Memory_t* memory, Process_t* process);
 void c_merge(c_Memory_t* b1, c_Memory_t* b2);
 void c_merge_blocks(c_Memory_t* head);
 int c_get_offset(c_Memory_t* head, char* PID);
 double c_calc_mem_usage(c_Memory_t* head);
+int c_cnt_holes(c_Memory_t* head);
 void c_display_memory(c_Memory_t* head);
 void c_block_free(c_Memory_t* head);
+double c_ext_fragmentation(c_Memory_t* head);
+void c_cnt_alloc(c_Alloc_stats_t* stats, int injected, int steps);
+void c_print_alloc_stats(c_Alloc_stats_t* stats);
+
+s_Memory_t* create_s_memory(c_Memory_t* head, Process_list_t* processes);
+int s_inject_mem(s_Memory_t* memory, Process_t* process, int* steps);
+void s_eject_mem(s_Memory_t* memory, Process_t* process);
 
-f_Memory_t* create_f_memory_table(unsigned short total, int frame_size);
-void f_inject_mem(int cycle, f_Memory_t* table, Process_t* process, queue_t* queue);
+f_Memory_t* create_f_memory_table(unsigned short total, int frame_size, int huge_frames);
+int f_inject_mem(int* ejected_mem, f_Memory_t* table, Process_t* process, queue_t* queue);
 void f_free_mem(int* ejected_mem, f_Memory_t* table, queue_t* queue);
 void f_eject_mem(int* ejected_mem, f_Memory_t* table, Process_t* process);
-void f_print_mem_frames(int* page_table, int pages);
+int f_cnt_listed(int* ejected_mem);
+void f_print_mem_frames(int* page_table, int pages, int compact);
 double f_mem_usage(f_Memory_t* table);
 void f_table_free(f_Memory_t* memory);
+void f_recount(f_Memory_t* table);
+int f_cnt_free_pages(f_Memory_t* table);
+int f_find_free_run(f_Memory_t* table, int len);
+int f_is_huge_mapped(f_Memory_t* table, Process_t* process, int group);
+void f_map_huge(f_Memory_t* table, Process_t* process);
+int f_cnt_pt_entries(f_Memory_t* table, Process_t* process);
+void f_cnt_eviction(f_Memory_t* table, int frames);
+void f_cnt_dispatch(f_Memory_t* table, Process_t* process);
+void f_print_paging_stats(f_Memory_t* table);
+void f_set_numa(f_Memory_t* table, int nodes, int policy);
+int f_node_of(f_Memory_t* table, int frame);
+void f_map_numa(f_Memory_t* table, Process_t* process);
+int f_remote_pages(f_Memory_t* table, Process_t* process);
+void f_print_node_stats(f_Memory_t* table);
+void f_attach_shared(f_Memory_t* table, Process_t* process);
+void f_cow_write(f_Memory_t* table, Process_t* process, int percent);
+void f_cnt_sharing(f_Memory_t* table);
+void f_print_sharing_stats(f_Memory_t* table);
+z_Pool_t* z_create_pool(f_Memory_t* table, int percent, double ratio, double pool_latency, double disk_latency);
+void z_reserve(f_Memory_t* table);
+void z_store(z_Pool_t* pool, Process_t* process, int page);
+void z_cnt_reload(z_Pool_t* pool, Process_t* process);
+void z_forget(z_Pool_t* pool, Process_t* process);
+void z_print_stats(z_Pool_t* pool);
+void z_pool_free(z_Pool_t* pool);
+int f_needs_eviction(f_Memory_t* table, Process_t* process, int alloc_mode);
+void f_pick_resident(f_Memory_t* table, queue_t* queue, int window, int alloc_mode, Process_t* ran);
 
 int v_cnt_allocated(Process_t* process);
-void v_inject_mem(Process_t* process, f_Memory_t* table, queue_t* queue, int cycle);
+int v_inject_mem(int* ejected_mem, Process_t* process, f_Memory_t* table, queue_t* queue);
 void v_free_mem(int* ejected_mem, f_Memory_t* table, queue_t* queue, int required_space);
 void v_eject_mem(int* ejected_mem, Process_t* process, f_Memory_t* table, int required_space);
 
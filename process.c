@@ -5,263 +5,85 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <string.h>
 
 #define DEBUG 0
 
-int _g_alloc_mode;
-/*
-The process manager runs in cycles. A cycle occurs after one quantum has elapsed. The process
-manager has its own notion of time, referred to from here on as the simulation time. The simulation
-time (TS ) starts at 0 and increases by the length of the quantum (Q) every cycle. For this project,
-Q will be an integer value between 1 and 3 (1 ≤ Q ≤ 3).
-*/
-void simulate_infinite(Process_list_t* processes, unsigned int quantum, int alloc_mode) {
-    unsigned int cycle = 0;
-    _g_alloc_mode = alloc_mode;
-    // create process queue
-    queue_t* process_q = create_queue();
-
-    while (is_complete(processes) == FALSE) {
-        // add newly submitted processes to the queue
-        add_processes(processes, process_q, cycle);
-        // if no process in queue, finish cycle
-        if (process_q->head == NULL) {
-            cycle += quantum;
-            continue;
-        }
-        
-        // if currently running process is finished, eject it from CPU and queue
-        if (process_q->head->process->duration == 0) {
-            Process_t* process = dequeue(process_q);
-            process->state = FINISHED; // put in queue functions?
-            process->finish_time = cycle;
-            print_finished_message(cycle, process, process_q->length);
-            
-        } 
-        // if not finished, take top of the queue to the back
-        else if (cycle != 0) {
-            requeue(process_q);
-        }
-
-        // if no process, finish cycle
-        if (process_q->head == NULL) {
-            cycle += quantum;
-            continue;
-        }
-
-        // a new process has started
-        if (process_q->head->process->state != RUNNING) {
-            process_q->head->process->state = RUNNING; // ditto
-            print_running_message(cycle, process_q->head->process, NULL);
-        }
-
-        //underflow protection
-        if (quantum > process_q->head->process->duration) {
-            process_q->head->process->duration = 0;
-        } else {
-            process_q->head->process->duration -= quantum;
+// Add processes that have elapsed their starting time into the process queue
+void add_processes(Process_list_t* processes, void* queue, unsigned int cycle) {
+     queue_t* process_q = (queue_t*) queue;
+     for (int i=0; i<processes->total_processes; i++) {
+        // add processes if their start time is now or has been
+        if (processes->array[i].start_time <= cycle && processes->array[i].state == NOT_READY) {
+            enqueue(process_q, &processes->array[i]);
         }
-        
-        cycle += quantum;
     }
-    find_and_print_statisics(processes, cycle-quantum);
-    free(process_q);
 }
 
-void simulate_firstfit(Process_list_t* processes, unsigned int quantum, int alloc_mode) {
-    unsigned int cycle = 0;
-    _g_alloc_mode = alloc_mode;
-    // create process queue
-    queue_t* process_q = create_queue();
-    c_Memory_t* memory_head = create_c_memory_block(NULL, SYSMEM, 0);
-
-    while (is_complete(processes) == FALSE) {
-        // add newly submitted processes to the queue
-        add_processes(processes, process_q, cycle);
-        // if no process in queue, finish cycle
-        if (process_q->head == NULL) {
-            cycle += quantum;
-            continue;
-        }
-
-        if (DEBUG) c_display_memory(memory_head);
-
-        // if currently running process is finished, eject it from CPU and queue
-        if (process_q->head->process->state == RUNNING && process_q->head->process->duration == 0) {
-            Process_t* process = dequeue(process_q);
-            c_eject_mem(memory_head, process);
-            
-            process->finish_time = cycle;
-            print_finished_message(cycle, process, process_q->length);    
-        } 
-
-        // if not finished, take top of the queue to the back
-        else if (cycle != 0) {
-            requeue(process_q);
-        }
-
-        // if no process, finish cycle
-        if (process_q->head == NULL) {
-            cycle += quantum;
-            continue;
-        }
-        
-        // a new process has started
-        if (process_q->head->process->state != RUNNING) {
-            while (process_q->head->process->allocated == FALSE && !c_inject_mem(memory_head, process_q->head->process)) {
-                requeue(process_q);
-            }
-            process_q->head->process->state = RUNNING; // ditto
-            print_running_message(cycle, process_q->head->process, memory_head);
-        }
-
-        //underflow protection
-        if (quantum > process_q->head->process->duration) {
-            process_q->head->process->duration = 0;
-        } else {
-            process_q->head->process->duration -= quantum;
-        }
-        
-        cycle += quantum;
-
-        if (cycle > 500) break;
+// Load control for paged/virtual memory. Arrived processes wait in the suspended queue and are let into the
+// process queue in order while the working sets of all admitted processes fit in memory, so round robin never
+// has to evict one admitted process to run another. As processes finish or their working sets shrink, pressure
+// drops and suspended processes are readmitted, those suspended after being admitted first.
+void admit_processes(Process_list_t* processes, void* suspended, void* queue, int capacity, unsigned int cycle) {
+    queue_t* suspended_q = (queue_t*) suspended;
+    queue_t* process_q = (queue_t*) queue;
+    add_processes(processes, suspended_q, cycle);
+    for (node_t* curr = suspended_q->head; curr != NULL; curr = curr->next) {
+        curr->process->state = SUSPENDED;
     }
-    c_block_free(memory_head);
-    free(process_q);
-    find_and_print_statisics(processes, cycle-quantum);
-}
-
-void simulate_paged(Process_list_t* processes, unsigned int quantum, int alloc_mode) {
-    unsigned int cycle = 0;
-    _g_alloc_mode = alloc_mode;
-    // create process queue
-    queue_t* process_q = create_queue();
-    f_Memory_t* memory = create_f_memory_table(SYSMEM, PAGESIZE);
-
-    while (is_complete(processes) == FALSE) {
-        if (DEBUG && cycle > 500) break;
-        // add newly submitted processes to the queue
-        add_processes(processes, process_q, cycle);
-        // if no process in queue, finish cycle
-        if (process_q->head == NULL) {
-            cycle += quantum;
-            continue;
-        }
-
 
-        // if currently running process is finished, eject it from CPU and queue
-        if (process_q->head->process->state == RUNNING && process_q->head->process->duration == 0) {
-            Process_t* process = dequeue(process_q);
-            print_evicted_message(cycle, process->page_table, process->pages);
-            f_eject_mem(NULL, memory, process);
-            process->finish_time = cycle;
-            print_finished_message(cycle, process, process_q->length);    
-        } 
-
-        // if not finished, take top of the queue to the back
-        else if (cycle != 0) {
-            requeue(process_q);
-        }
+    int demand = 0;
+    for (node_t* curr = process_q->head; curr != NULL; curr = curr->next) {
+        demand += curr->process->working_set;
+    }
 
-        // if no process, finish cycle
-        if (process_q->head == NULL) {
-            cycle += quantum;
-            continue;
+    while (suspended_q->head != NULL) {
+        Process_t* process = suspended_q->head->process;
+        if (process->working_set > capacity) {
+            process->working_set = capacity;
         }
-        
-        // a new process has started
-        if (process_q->head->process->state != RUNNING) {
-            if (process_q->head->process->allocated == FALSE) f_inject_mem(cycle, memory, process_q->head->process, process_q); 
-            process_q->head->process->state = RUNNING; // ditto
-            print_running_message(cycle, process_q->head->process, memory);
-        }
-
-        //underflow protection
-        if (quantum > process_q->head->process->duration) {
-            process_q->head->process->duration = 0;
-        } else {
-            process_q->head->process->duration -= quantum;
+        // an empty process queue always takes the next process so the simulation keeps moving
+        if (process_q->head != NULL && demand + process->working_set > capacity) {
+            break;
         }
-        
-        cycle += quantum;
+        dequeue(suspended_q);
+        enqueue(process_q, process);
+        process->state = READY;
+        process->waited += cycle - process->admit_time;
+        process->admit_time = cycle;
+        demand += process->working_set;
     }
-    f_table_free(memory);
-    free(process_q);
-    find_and_print_statisics(processes, cycle-quantum);
 }
 
-void simulate_virtual(Process_list_t* processes, unsigned int quantum, int alloc_mode) {
-        unsigned int cycle = 0;
-    _g_alloc_mode = alloc_mode;
-    // create process queue
-    queue_t* process_q = create_queue();
-    f_Memory_t* memory = create_f_memory_table(SYSMEM, PAGESIZE);
-
-    while (is_complete(processes) == FALSE) {
-        if (DEBUG && cycle > 500) break;
-        // add newly submitted processes to the queue
-        add_processes(processes, process_q, cycle);
-        // if no process in queue, finish cycle
-        if (process_q->head == NULL) {
-            cycle += quantum;
-            continue;
-        }
-
-        //print_queue(process_q);
-
-        // if currently running process is finished, eject it from CPU and queue
-        if (process_q->head->process->state == RUNNING && process_q->head->process->duration == 0) {
-            Process_t* process = dequeue(process_q);
-            print_evicted_message(cycle, process->page_table, process->pages);
-            f_eject_mem(NULL, memory, process);
-            process->finish_time = cycle;
-            print_finished_message(cycle, process, process_q->length);    
-        } 
-
-        // if not finished, take top of the queue to the back
-        else if (cycle != 0) {
-            requeue(process_q);
-        }
-
-        // if no process, finish cycle
-        if (process_q->head == NULL) {
-            cycle += quantum;
-            continue;
-        }
-        
-        // a new process has started
-        if (process_q->head->process->state != RUNNING) {
-            if (v_cnt_allocated(process_q->head->process) < REQ_PAGES) {
-                v_inject_mem(process_q->head->process, memory, process_q, cycle);
-            }
-            
-            process_q->head->process->state = RUNNING; 
-            print_running_message(cycle, process_q->head->process, memory);
+// Displays how many processes load control held back, for how long, and how often it suspended admitted ones
+void print_load_control_stats(Process_list_t* processes) {
+    int suspended = 0;
+    int suspends = 0;
+    unsigned int max_wait = 0;
+    double avg_wait = 0;
+    for (int i=0; i<processes->total_processes; i++) {
+        unsigned int wait = processes->array[i].waited;
+        suspends += processes->array[i].suspends;
+        if (wait > 0) {
+            suspended += 1;
         }
-
-        //underflow protection
-        if (quantum > process_q->head->process->duration) {
-            process_q->head->process->duration = 0;
-        } else {
-            process_q->head->process->duration -= quantum;
+        if (wait > max_wait) {
+            max_wait = wait;
         }
-        
-        cycle += quantum;
+        avg_wait += wait;
     }
-    f_table_free(memory);
-    free(process_q);
-    find_and_print_statisics(processes, cycle-quantum);
+    avg_wait = ceil(avg_wait/processes->total_processes);
+    printf("Suspended processes %d\nSuspended time %.f %u\nSuspensions %d\n", suspended, avg_wait, max_wait, suspends);
 }
 
-// Add processes that have elapsed their starting time into the process queue
-void add_processes(Process_list_t* processes, void* queue, unsigned int cycle) {
-     queue_t* process_q = (queue_t*) queue;
-     for (int i=0; i<processes->total_processes; i++) {
-        // add processes if their start time is now or has been
-        if (processes->array[i].start_time <= cycle && processes->array[i].state == NOT_READY) {
-            enqueue(process_q, &processes->array[i]);
+// Checks if any process shares pages with a sharing group
+int has_shared_pages(Process_list_t* processes) {
+    for (int i=0; i<processes->total_processes; i++) {
+        if (processes->array[i].shared > 0) {
+            return TRUE;
         }
     }
+    return FALSE;
 }
 
 // Checks if any process is still to run
@@ -279,56 +101,44 @@ void print_finished_message(int cycle, Process_t* process, int queue_length) {
     printf("%u,FINISHED,process-name=%s,proc-remaining=%u\n", cycle, process->PID, queue_length);
 }
 
-void print_running_message(int cycle, Process_t* process, void* memory) {
-    c_Memory_t* mem_head;
-    f_Memory_t* table;
-    switch (_g_alloc_mode) {
-        case INFINITE:
-            printf("%u,RUNNING,process-name=%s,remaining-time=%u\n", cycle, process->PID, process->duration);
-            break;
-        case FIRSTFIT:
-            mem_head = (c_Memory_t*) memory;
-            printf("%u,RUNNING,process-name=%s,remaining-time=%u,mem-usage=%.f%%,allocated-at=%d\n", 
-                    cycle, process->PID, process->duration, (c_calc_mem_usage(mem_head)*100), c_get_offset(mem_head, process->PID));
-            break;
-        case PAGED:
-            table = (f_Memory_t*) memory;
-            printf("%u,RUNNING,process-name=%s,remaining-time=%u,mem-usage=%.f%%,mem-frames=", 
-                    cycle, process->PID, process->duration, ceil(f_mem_usage(table)*100));
-            f_print_mem_frames(process->page_table, process->pages);
-            break;
-        case VIRTUAL:
-            table = (f_Memory_t*) memory;
-            printf("%u,RUNNING,process-name=%s,remaining-time=%u,mem-usage=%.f%%,mem-frames=", 
-                    cycle, process->PID, process->duration, ceil(f_mem_usage(table)*100));
-            f_print_mem_frames(process->page_table, process->pages);
-            break;
-        
-    }
+void inf_print_running_message(int cycle, Process_t* process) {
+    printf("%u,RUNNING,process-name=%s,remaining-time=%u\n", cycle, process->PID, process->duration);
+}
+
+void c_print_running_message(int cycle, Process_t* process, void* head) {
+    c_Memory_t* mem_head = (c_Memory_t*) head;
+    printf("%u,RUNNING,process-name=%s,remaining-time=%u,mem-usage=%.f%%,allocated-at=%d\n", 
+            cycle, process->PID, process->duration, (c_calc_mem_usage(mem_head)*100), c_get_offset(mem_head, process->PID));
 }
 
-void print_evicted_message(int cycle, int* page_table, int pages) {
+// used by both paged and virtual memory
+void f_print_running_message(int cycle, Process_t* process, void* memory, int compact) {
+    f_Memory_t* table = (f_Memory_t*) memory;
+    printf("%u,RUNNING,process-name=%s,remaining-time=%u,mem-usage=%.f%%,mem-frames=", 
+            cycle, process->PID, process->duration, ceil(f_mem_usage(table)*100));
+    f_print_mem_frames(process->page_table, process->pages, compact);
+}
+
+void print_evicted_message(int cycle, int* page_table, int pages, int compact) {
     printf("%u,EVICTED,evicted-frames=", cycle);
-    f_print_mem_frames(page_table, pages);
+    f_print_mem_frames(page_table, pages, compact);
 }
 
-// Calculate and display turnaround, overhead and makespan statisics for the ran processes
-void find_and_print_statisics(Process_list_t* processes, int makespan) {
-    int* turnaround = (int*) malloc(sizeof(int)*processes->total_processes);
-    assert(turnaround);
+// Calculate turnaround, overhead and makespan statisics for the ran processes
+void find_statistics(Process_list_t* processes, int makespan, Sim_stats_t* stats) {
     double avg_turnaround = 0, avg_overhead = 0;
     double max_overhead = 0;
     
     for (int i=0; i<processes->total_processes; i++) {
         // "turnaround time is the time elapsed between the arrival and the completion of a process"
-        turnaround[i] = processes->array[i].finish_time - processes->array[i].start_time;
-        avg_turnaround += turnaround[i];
+        int turnaround = processes->array[i].finish_time - processes->array[i].start_time;
+        avg_turnaround += turnaround;
 
         // "The time overhead of a process is defined as its turnaround time divided by its service time"
-        double overhead = (double)turnaround[i] / processes->array[i].service_time;
+        double overhead = (double)turnaround / processes->array[i].service_time;
         avg_overhead += overhead;
 
-        if (DEBUG) printf("%s had turnaround %d and overhead %f\n", processes->array[i].PID, turnaround[i], overhead);
+        if (DEBUG) printf("%s had turnaround %d and overhead %f\n", processes->array[i].PID, turnaround, overhead);
         if (overhead > max_overhead) {
             max_overhead = overhead;
         }
@@ -337,6 +147,95 @@ void find_and_print_statisics(Process_list_t* processes, int makespan) {
     avg_turnaround = ceil(avg_turnaround/processes->total_processes);
     avg_overhead = round(avg_overhead/processes->total_processes*100)/100;
 
-    free(turnaround);
-    printf("Turnaround time %.f\nTime overhead %.2f %.2f\nMakespan %d\n", avg_turnaround, max_overhead, avg_overhead, makespan);
-}
\ No newline at end of file
+    stats->avg_turnaround = avg_turnaround;
+    stats->max_overhead = max_overhead;
+    stats->avg_overhead = avg_overhead;
+    stats->makespan = makespan;
+}
+
+// Display turnaround, overhead and makespan statisics for the ran processes
+void find_and_print_statisics(Process_list_t* processes, int makespan) {
+    Sim_stats_t stats;
+    find_statistics(processes, makespan, &stats);
+    printf("Turnaround time %.f\nTime overhead %.2f %.2f\nMakespan %d\n", stats.avg_turnaround, stats.max_overhead, 
+            stats.avg_overhead, stats.makespan);
+}
+
+// Fills in a process from one line of a trace. Returns 1 for a process, 0 for a blank line and -1 for a line
+// that is not a process, which ends the trace.
+int parse_process(char* line, Process_t* process) {
+    __uint32_t time, duration; 
+    __uint16_t memory;     
+    char PID[9];
+    int group, shared;
+    // a sharing group and how many leading pages are shared with it may follow, a group alone shares all
+    int fields = sscanf(line, "%u %8s %u %hu %d %d", &time, PID, &duration, &memory, &group, &shared);
+    if (fields == EOF) {
+        return 0;
+    }
+    if (fields < 4) {
+        return -1;
+    }
+    // loading attributes for each process
+    process->pages = ceil(memory/(double)PAGESIZE); // avoid int division 
+    process->page_table = (int*) malloc(sizeof(int)*process->pages);
+    for (int j=0; j<process->pages; j++) {
+        process->page_table[j] = -1;
+    }
+    process->start_time = time;
+    process->duration = duration;
+    process->service_time = duration;
+    process->memory = memory;
+    process->allocated = FALSE;
+    process->state = NOT_READY;
+    process->working_set = process->pages;
+    process->admit_time = time;
+    process->waited = 0;
+    process->suspends = 0;
+    process->skips = 0;
+    process->home_node = -1;
+    process->group = fields > 4 ? group : -1;
+    process->shared = 0;
+    if (fields > 4 && group >= 0) {
+        if (fields == 5 || shared > process->pages) {
+            shared = process->pages;
+        }
+        process->shared = shared > 0 ? shared : 0;
+    }
+    process->written = 0;
+    process->block = NULL;
+    process->swap = NULL;
+    strcpy(process->PID, PID);
+    return 1;
+}
+
+// Makes an independent copy of a process list, so the same trace can be simulated more than once
+Process_list_t* copy_processes(Process_list_t* processes) {
+    Process_list_t* copy = (Process_list_t*) malloc(sizeof(Process_list_t));
+    assert(copy);
+    copy->total_processes = processes->total_processes;
+    copy->array = (Process_t*) malloc(sizeof(Process_t)*(processes->total_processes + 1));
+    assert(copy->array);
+    memcpy(copy->array, processes->array, sizeof(Process_t)*processes->total_processes);
+    for (int i=0; i<copy->total_processes; i++) {
+        copy->array[i].page_table = (int*) malloc(sizeof(int)*copy->array[i].pages);
+        assert(copy->array[i].page_table);
+        memcpy(copy->array[i].page_table, processes->array[i].page_table, sizeof(int)*copy->array[i].pages);
+        if (processes->array[i].swap != NULL) {
+            copy->array[i].swap = (int*) malloc(sizeof(int)*copy->array[i].pages);
+            assert(copy->array[i].swap);
+            memcpy(copy->array[i].swap, processes->array[i].swap, sizeof(int)*copy->array[i].pages);
+        }
+    }
+    return copy;
+}
+
+// Frees a process list and all the page tables in it
+void free_processes(Process_list_t* processes) {
+    for (int i = 0; i < processes->total_processes; i++) {
+        free(processes->array[i].page_table);
+        free(processes->array[i].swap);
+    }
+    free(processes->array);
+    free(processes);
+}
@@ -1,6 +1,8 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 
+#include <stdio.h>
+
 #define FALSE 0
 #define TRUE 1
 
@@ -8,6 +10,7 @@
 #define READY 1
 #define RUNNING 2
 #define FINISHED 3
+#define SUSPENDED 4
 
 
 typedef struct {
@@ -21,6 +24,17 @@ typedef struct {
     int pages;                  // total page count for process
     short allocated;            // boolean value if memory is allocated or not
     int state;                  // what state the process is currently in 
+    int working_set;            // pages the process needs resident to run without faulting, measured as it runs
+    unsigned int admit_time;    // when load control last let the process into or out of the process queue
+    unsigned int waited;        // cycles load control held the process back, over all of its suspensions
+    int suspends;               // times load control suspended the process after admitting it
+    int skips;                  // times the process was passed over for one already in memory
+    int home_node;              // NUMA node the process runs on, -1 until it is first loaded
+    int group;                  // sharing group, processes in the same group share memory, -1 for none
+    int shared;                 // leading pages shared with the rest of the group
+    int written;                // shared pages already copied on write, always the first ones
+    void* block;                // c_Memory_t block holding the process in segregated memory
+    int* swap;                  // where each evicted page is kept with a swap pool, NULL until one is evicted
 } Process_t;
 
 typedef struct {
@@ -28,19 +42,55 @@ typedef struct {
     int total_processes;
 } Process_list_t;
 
+// Settings given on the command line for a simulation run
+typedef struct {
+    unsigned int quantum;       // length of a cycle
+    int alloc_mode;             // which memory model is simulated
+    int huge_frames;            // small frames per huge frame, 0 if huge pages are disabled, not with numa_nodes
+    int load_control;           // boolean value if processes are held back or suspended while memory is overcommitted
+    int resident_window;        // how far past the queue head to look for a process in memory, 0 for plain RR
+    char* checkpoint_file;      // where to save a snapshot of the simulation, NULL for no snapshot
+    unsigned int checkpoint_cycle; // first cycle at which the snapshot is saved
+    int percentiles;            // boolean value if tail statistics are reported
+    int numa_nodes;             // NUMA nodes paged/virtual memory is split over, 0 or 1 for flat memory
+    int numa_policy;            // NUMA placement policy
+    unsigned int remote_penalty;// cycles a process stalls on loading with all of its pages remote
+    int cow_writes;             // percent of its still shared pages a process writes each time it runs
+    int alloc_stats;            // boolean value if continuous memory allocator statistics are reported
+    int compact_frames;         // boolean value if frame lists are printed as ranges of contiguous frames
+    unsigned short memory_size; // KBs of memory, a multiple of the page size, 0 for the default SYSMEM
+    int swap_percent;           // percent of virtual memory set aside as a compressed swap pool
+    double swap_ratio;          // pages each pool frame holds, 0 if there is no swap tier
+    double swap_pool_latency;   // cycles to reload a page from the pool
+    double swap_disk_latency;   // cycles to reload a page from backing store
+    unsigned int telemetry_interval; // cycles between telemetry samples, 0 for no telemetry
+    char* telemetry_file;       // where the telemetry samples are written at the end
+} Sim_options_t;
+
+// Summary statistics of a finished simulation
+typedef struct {
+    double avg_turnaround;      // rounded up to the nearest integer
+    double max_overhead;
+    double avg_overhead;        // rounded to two decimal places
+    int makespan;
+} Sim_stats_t;
+
 
+int parse_process(char* line, Process_t* process);
+Process_list_t* copy_processes(Process_list_t* processes);
+void free_processes(Process_list_t* processes);
 int is_complete(Process_list_t* processes);
-void simulate_infinite(Process_list_t* processes, unsigned int quantum, int alloc_mode);
-void simulate_firstfit(Process_list_t* processes, unsigned int quantum, int alloc_mode);
-void simulate_paged(Process_list_t* processes, unsigned int quantum, int alloc_mode);
-void simulate_virtual(Process_list_t* processes, unsigned int quantum, int alloc_mode);
-void inf_print_state_message(int cycle, Process_t* process, int queue_length);
-void c_print_state_message(int cycle, Process_t* process, void* head, int queue_length);
+int has_shared_pages(Process_list_t* processes);
+void find_statistics(Process_list_t* processes, int makespan, Sim_stats_t* stats);
 void find_and_print_statisics(Process_list_t* processes, int makespan);
 void add_processes(Process_list_t* processes, void* queue, unsigned int cycle);
+void admit_processes(Process_list_t* processes, void* suspended, void* queue, int capacity, unsigned int cycle);
+void print_load_control_stats(Process_list_t* processes);
 
 void print_finished_message(int cycle, Process_t* process, int queue_length);
-void print_running_message(int cycle, Process_t* process, void* memory);
-void print_evicted_message(int cycle, int* page_table, int pages);
+void inf_print_running_message(int cycle, Process_t* process);
+void c_print_running_message(int cycle, Process_t* process, void* head);
+void f_print_running_message(int cycle, Process_t* process, void* memory, int compact);
+void print_evicted_message(int cycle, int* page_table, int pages, int compact);
 
 #endif
\ No newline at end of file
@@ -75,6 +75,43 @@ Process_t* requeue(queue_t* queue) {
     return top->process;
 }
 
+// add node to the front of the queue, leaving the state of the process as it is
+void push(queue_t* queue, Process_t* process) {
+    node_t* process_node = create_node(process);
+    process_node->next = queue->head;
+    queue->head = process_node;
+    queue->length += 1;
+}
+
+// pop the node lowest in the queue and return it, leaving the state of the process as it is
+Process_t* withdraw(queue_t* queue) {
+    if (queue->head == NULL) {
+        return NULL;
+    }
+    node_t** link = &queue->head;
+    while ((*link)->next != NULL) {
+        link = &(*link)->next; // go to end of queue
+    }
+    node_t* tail = *link;
+    Process_t* process = tail->process;
+    *link = NULL;
+    queue->length -= 1;
+    free(tail);
+    return process;
+}
+
+// move the node directly after prev to the top of the queue and return its data
+Process_t* promote(queue_t* queue, node_t* prev) {
+    node_t* node = prev->next;
+    if (node == NULL) {
+        return NULL;
+    }
+    prev->next = node->next;
+    node->next = queue->head;
+    queue->head = node;
+    return node->process;
+}
+
 void print_queue(queue_t* queue) {
     node_t* curr = queue->head;
     int queue_pos = 0;
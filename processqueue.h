@@ -19,6 +19,9 @@ node_t* create_node(Process_t* process);
 void enqueue(queue_t* queue, Process_t* process);
 Process_t* dequeue(queue_t* queue);
 Process_t* requeue(queue_t* queue);
+Process_t* promote(queue_t* queue, node_t* prev);
+void push(queue_t* queue, Process_t* process);
+Process_t* withdraw(queue_t* queue);
 void print_queue(queue_t* queue);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "profile.h"
+#include <stdio.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifdef SIM_PROFILE
+
+_Thread_local int prof_enabled = 0;
+_Thread_local Prof_phase_t prof_phases[PROF_PHASES];
+// wall time of the whole run, the base for each phase's share since phases nest
+static _Thread_local unsigned long long prof_run_start;
+static _Thread_local unsigned long long prof_run_ticks;
+
+static const char* PHASE_NAMES[PROF_PHASES] = {"is_complete", "arrivals", "requeue", "c_inject_mem", 
+        "c_merge_blocks", "f_cnt_free_pages", "output"};
+
+// Cheapest clock available, the time stamp counter on x86 and nanoseconds elsewhere
+unsigned long long prof_now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+void prof_enable() {
+    prof_enabled = 1;
+}
+
+// Marks the start and end of the simulation run that the phases are measured against
+void prof_run_begin() {
+    if (prof_enabled) prof_run_start = prof_now();
+}
+
+void prof_run_end() {
+    if (prof_enabled) prof_run_ticks += prof_now() - prof_run_start;
+}
+
+// Prints the time and calls of each phase to stderr, so the simulation log is left as is. Shares are of the
+// whole run, a nested phase is also counted in the phase around it so they need not add up to 100%.
+void prof_report(unsigned long long events) {
+    unsigned long long total = prof_run_ticks;
+    fprintf(stderr, "Profile of %llu events, %llu %s in the run\n", events, total,
+#if defined(__x86_64__) || defined(__i386__)
+            "TSC ticks");
+#else
+            "nanoseconds");
+#endif
+    fprintf(stderr, "%-18s %12s %14s %10s %12s %7s\n", "phase", "calls", "ticks", "ticks/call", "calls/event", "share");
+    for (int i=0; i<PROF_PHASES; i++) {
+        Prof_phase_t* phase = &prof_phases[i];
+        fprintf(stderr, "%-18s %12llu %14llu %10.1f %12.2f %6.1f%%\n", PHASE_NAMES[i], phase->calls, phase->ticks,
+                phase->calls ? (double)phase->ticks / phase->calls : 0.0,
+                events ? (double)phase->calls / events : 0.0,
+                total ? 100.0 * phase->ticks / total : 0.0);
+    }
+}
+
+#else
+
+void prof_enable() {
+}
+
+void prof_run_begin() {
+}
+
+void prof_run_end() {
+}
+
+void prof_report(unsigned long long events) {
+    (void) events;
+    fprintf(stderr, "allocate: built without SIM_PROFILE, no profile to show\n");
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// Phases of the simulator that are timed by --profile, phases may nest inside each other
+#define PROF_IS_COMPLETE 0
+#define PROF_ARRIVALS 1
+#define PROF_REQUEUE 2
+#define PROF_C_INJECT 3
+#define PROF_C_MERGE 4
+#define PROF_F_FREE_PAGES 5
+#define PROF_OUTPUT 6
+#define PROF_PHASES 7
+
+// Build with -DSIM_PROFILE for the timers, without it PROF_BEGIN/PROF_END compile to nothing
+#ifdef SIM_PROFILE
+
+typedef struct {
+    unsigned long long ticks;   // time spent in the phase
+    unsigned long long calls;   // times the phase ran
+} Prof_phase_t;
+
+// per thread, so simulations running on different threads do not clash
+extern _Thread_local int prof_enabled;
+extern _Thread_local Prof_phase_t prof_phases[PROF_PHASES];
+
+unsigned long long prof_now();
+
+#define PROF_BEGIN(phase) unsigned long long prof_start_##phase = prof_enabled ? prof_now() : 0
+#define PROF_END(phase)                                                     \
+    if (prof_enabled) {                                                     \
+        prof_phases[phase].ticks += prof_now() - prof_start_##phase;        \
+        prof_phases[phase].calls += 1;                                      \
+    }
+
+#else
+
+#define PROF_BEGIN(phase)
+#define PROF_END(phase)
+
+#endif
+
+void prof_enable();
+void prof_run_begin();
+void prof_run_end();
+void prof_report(unsigned long long events);
+
+#endif
@@ -0,0 +1,366 @@
+#include "server.h"
+#include "sim.h"
+#include "process.h"
+#include "memory.h"
+#include "ingest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define SERVER_CACHE 64     // parsed traces kept, the least recently used is dropped first
+#define SERVER_LINE 512     // longest request or reply line
+#define SERVER_TRACE (64 << 20) // largest trace accepted, in bytes
+
+// A parsed trace kept between jobs
+typedef struct {
+    unsigned long long hash;    // FNV-1a hash of the trace text
+    Process_list_t* processes;
+    unsigned long used;         // request count when the trace was last asked for
+} Trace_entry_t;
+
+// One run asked for by a client
+typedef struct {
+    char id[32];
+    unsigned long long hash;    // trace to run, looked up when the batch runs
+    Process_list_t* processes;  // the trace, NULL if it is not loaded
+    Sim_options_t options;
+} Job_t;
+
+// The daemon, a trace cache and a pool of workers running one batch of jobs at a time
+typedef struct {
+    Trace_entry_t cache[SERVER_CACHE];
+    int cached;
+    unsigned long requests;
+    int client_fd;              // connection the running batch came from
+    Job_t* jobs;                // jobs queued by the client, run together on RUN
+    int total;
+    int next;                   // next job a worker picks up
+    int done;                   // jobs of the batch finished so far
+    int stopping;               // boolean value if the workers should exit
+    int threads;                // workers, traces are parsed on as many threads
+    pthread_mutex_t lock;       // guards the batch and replies to the client
+    pthread_cond_t work;        // a batch is ready or the daemon is stopping
+    pthread_cond_t finished;    // the last job of the batch is done
+} Server_t;
+
+// FNV-1a, 64 bit
+static unsigned long long hash_text(char* text, size_t len) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i=0; i<len; i++) {
+        hash ^= (unsigned char) text[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Writes a reply line to the client, failures are ignored as the client may have gone away
+static void reply(int fd, const char* format, ...) {
+    char line[SERVER_LINE];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (len >= (int) sizeof(line)) len = sizeof(line) - 1;
+    for (int sent = 0; sent < len; ) {
+        ssize_t n = send(fd, line + sent, len - sent, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        sent += n;
+    }
+}
+
+static Trace_entry_t* find_trace(Server_t* server, unsigned long long hash) {
+    for (int i=0; i<server->cached; i++) {
+        if (server->cache[i].hash == hash) {
+            server->cache[i].used = server->requests;
+            return &server->cache[i];
+        }
+    }
+    return NULL;
+}
+
+// Parses a trace unless the same text is already cached, replies with the hash jobs refer to it by
+static void load_trace(Server_t* server, int fd, char* text, size_t len) {
+    unsigned long long hash = hash_text(text, len);
+    Trace_entry_t* entry = find_trace(server, hash);
+    if (entry == NULL) {
+        if (server->cached == SERVER_CACHE) {
+            // no batch is running while requests are read, so no job holds the dropped trace
+            entry = &server->cache[0];
+            for (int i=1; i<server->cached; i++) {
+                if (server->cache[i].used < entry->used) entry = &server->cache[i];
+            }
+            free_processes(entry->processes);
+        } else {
+            entry = &server->cache[server->cached++];
+        }
+        // the workers are idle between batches, the trace is parsed on as many threads
+        entry->hash = hash;
+        entry->processes = get_processes_from_text(text, len, server->threads);
+        entry->used = server->requests;
+    }
+    reply(fd, "TRACE %016llx %d\n", hash, entry->processes->total_processes);
+}
+
+static int parse_mode(char* name) {
+    if (strcasecmp(name, "infinite") == 0) return INFINITE;
+    if (strcasecmp(name, "first-fit") == 0) return FIRSTFIT;
+    if (strcasecmp(name, "segregated") == 0) return SEGREGATED;
+    if (strcasecmp(name, "paged") == 0) return PAGED;
+    if (strcasecmp(name, "virtual") == 0) return VIRTUAL;
+    return -1;
+}
+
+// Checks a job can finish, a process that can never fit in memory would run forever. Returns the problem or NULL
+static const char* check_job(Job_t* job) {
+    if (job->processes == NULL) {
+        return "unknown trace";
+    }
+    return sim_check(job->processes, &job->options);
+}
+
+// Runs a job on a private copy of its trace and formats the result line
+static void run_job(Job_t* job, char* line) {
+    const char* problem = check_job(job);
+    if (problem != NULL) {
+        snprintf(line, SERVER_LINE, "ERROR %s %s\n", job->id, problem);
+        return;
+    }
+    Process_list_t* processes = copy_processes(job->processes);
+    Sim_t* sim = sim_create(processes, &job->options);
+    sim_run(sim);
+    Sim_stats_t stats;
+    sim_get_stats(sim, &stats);
+    snprintf(line, SERVER_LINE, "RESULT %s makespan=%d,turnaround=%.f,max-overhead=%.2f,avg-overhead=%.2f\n",
+            job->id, stats.makespan, stats.avg_turnaround, stats.max_overhead, stats.avg_overhead);
+    sim_destroy(sim);
+    free_processes(processes);
+}
+
+// Takes jobs of the running batch until the daemon stops, streaming each result back as soon as it is known
+static void* server_worker(void* data) {
+    Server_t* server = (Server_t*) data;
+    char line[SERVER_LINE];
+    pthread_mutex_lock(&server->lock);
+    while (TRUE) {
+        while (!server->stopping && server->next >= server->total) {
+            pthread_cond_wait(&server->work, &server->lock);
+        }
+        if (server->stopping) {
+            break;
+        }
+        Job_t* job = &server->jobs[server->next++];
+        pthread_mutex_unlock(&server->lock);
+        run_job(job, line);
+        pthread_mutex_lock(&server->lock);
+        reply(server->client_fd, "%s", line);
+        if (++server->done == server->total) {
+            pthread_cond_signal(&server->finished);
+        }
+    }
+    pthread_mutex_unlock(&server->lock);
+    return NULL;
+}
+
+// Hands the queued jobs to the workers and waits for all of them
+static void run_batch(Server_t* server, int fd) {
+    int total = server->total;
+    for (int i=0; i<total; i++) {
+        Trace_entry_t* entry = find_trace(server, server->jobs[i].hash);
+        server->jobs[i].processes = entry != NULL ? entry->processes : NULL;
+    }
+    pthread_mutex_lock(&server->lock);
+    server->client_fd = fd;
+    server->next = 0;
+    server->done = 0;
+    pthread_cond_broadcast(&server->work);
+    while (server->done < server->total) {
+        pthread_cond_wait(&server->finished, &server->lock);
+    }
+    server->total = 0;
+    pthread_mutex_unlock(&server->lock);
+    reply(fd, "DONE %d\n", total);
+}
+
+// Queues a job line, replies with an error if it cannot be understood
+static void add_job(Server_t* server, int fd, char* line) {
+    char id[32], mode[16];
+    unsigned long long hash;
+    unsigned int quantum, memory_size = SYSMEM;
+    int fields = sscanf(line, "JOB %31s %llx %u %15s %u", id, &hash, &quantum, mode, &memory_size);
+    if (fields < 4 || quantum == 0 || parse_mode(mode) == -1 || memory_size < PAGESIZE || memory_size > 65532) {
+        reply(fd, "ERROR %s bad job\n", fields >= 1 ? id : "-");
+        return;
+    }
+    server->jobs = (Job_t*) realloc(server->jobs, sizeof(Job_t)*(server->total + 1));
+    assert(server->jobs);
+    Job_t* job = &server->jobs[server->total++];
+    memset(job, 0, sizeof(Job_t));
+    strcpy(job->id, id);
+    job->hash = hash;
+    job->options.quantum = quantum;
+    job->options.alloc_mode = parse_mode(mode);
+    job->options.memory_size = memory_size - memory_size % PAGESIZE;
+}
+
+// Serves one connection until the client quits or hangs up, returns TRUE if the daemon should stop
+static int serve_client(Server_t* server, int fd) {
+    FILE* in = fdopen(dup(fd), "r");
+    assert(in);
+    char line[SERVER_LINE];
+    int stop = FALSE;
+    while (fgets(line, sizeof(line), in) != NULL) {
+        server->requests += 1;
+        line[strcspn(line, "\r\n")] = '\0';
+        char path[SERVER_LINE];
+        size_t len;
+        if (sscanf(line, "LOAD %511s", path) == 1) {
+            FILE* fptr = fopen(path, "r");
+            if (fptr == NULL) {
+                reply(fd, "ERROR %s cannot open\n", path);
+                continue;
+            }
+            fseek(fptr, 0, SEEK_END);
+            long size = ftell(fptr);
+            rewind(fptr);
+            if (size < 0 || size > SERVER_TRACE) {
+                fclose(fptr);
+                reply(fd, size < 0 ? "ERROR %s cannot open\n" : "ERROR %s too large\n", path);
+                continue;
+            }
+            len = size;
+            char* text = (char*) malloc(len + 1);
+            assert(text);
+            len = fread(text, 1, len, fptr);
+            fclose(fptr);
+            load_trace(server, fd, text, len);
+            free(text);
+        } else if (sscanf(line, "TRACE %zu", &len) == 1) {
+            // the trace text cannot be skipped without reading it, so the connection is dropped
+            if (len > SERVER_TRACE) {
+                reply(fd, "ERROR - trace too large\n");
+                break;
+            }
+            char* text = (char*) malloc(len + 1);
+            assert(text);
+            len = fread(text, 1, len, in);
+            load_trace(server, fd, text, len);
+            free(text);
+        } else if (strncmp(line, "JOB ", 4) == 0) {
+            add_job(server, fd, line);
+        } else if (strcmp(line, "RUN") == 0) {
+            run_batch(server, fd);
+        } else if (strcmp(line, "QUIT") == 0) {
+            break;
+        } else if (strcmp(line, "SHUTDOWN") == 0) {
+            stop = TRUE;
+            break;
+        } else if (line[0] != '\0') {
+            reply(fd, "ERROR - unknown request\n");
+        }
+    }
+    // jobs queued but never run are dropped with the connection
+    server->total = 0;
+    fclose(in);
+    return stop;
+}
+
+// Listens on the socket and serves clients one after another, running their jobs on 'threads' workers
+int server_run(char* socket_path, int threads) {
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "socket path too long: %s\n", socket_path);
+        return 1;
+    }
+    strcpy(addr.sun_path, socket_path);
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path);
+    if (listen_fd < 0 || bind(listen_fd, (struct sockaddr*) &addr, sizeof(addr)) < 0 || listen(listen_fd, 8) < 0) {
+        perror(socket_path);
+        if (listen_fd >= 0) close(listen_fd);
+        return 1;
+    }
+
+    Server_t* server = (Server_t*) calloc(1, sizeof(Server_t));
+    assert(server);
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_cond_init(&server->work, NULL);
+    pthread_cond_init(&server->finished, NULL);
+    if (threads < 1) threads = 1;
+    server->threads = threads;
+    pthread_t* workers = (pthread_t*) malloc(sizeof(pthread_t)*threads);
+    assert(workers);
+    for (int i=0; i<threads; i++) {
+        int created = pthread_create(&workers[i], NULL, server_worker, server);
+        assert(created == 0);
+    }
+
+    int stop = FALSE;
+    while (!stop) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        stop = serve_client(server, fd);
+        close(fd);
+    }
+
+    pthread_mutex_lock(&server->lock);
+    server->stopping = TRUE;
+    pthread_cond_broadcast(&server->work);
+    pthread_mutex_unlock(&server->lock);
+    for (int i=0; i<threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    for (int i=0; i<server->cached; i++) {
+        free_processes(server->cache[i].processes);
+    }
+    pthread_mutex_destroy(&server->lock);
+    pthread_cond_destroy(&server->work);
+    pthread_cond_destroy(&server->finished);
+    free(server->jobs);
+    free(server);
+    close(listen_fd);
+    unlink(socket_path);
+    return 0;
+}
+
+// Sends standard input to the daemon and prints its replies until it closes the connection. The daemon may
+// still be starting up, so connecting is retried for a second.
+int server_client(char* socket_path) {
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    int connected = -1;
+    for (int tries=0; fd >= 0 && connected < 0 && tries < 100; tries++) {
+        connected = connect(fd, (struct sockaddr*) &addr, sizeof(addr));
+        if (connected < 0) usleep(10000);
+    }
+    if (connected < 0) {
+        perror(socket_path);
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), stdin)) > 0) {
+        if (send(fd, buffer, n, MSG_NOSIGNAL) < 0) break;
+    }
+    shutdown(fd, SHUT_WR);
+    ssize_t got;
+    while ((got = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        fwrite(buffer, 1, got, stdout);
+    }
+    close(fd);
+    return 0;
+}
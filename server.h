@@ -0,0 +1,20 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+/*
+Simulation daemon. Clients connect to a Unix domain socket and send requests one per line:
+    LOAD <path>                             parse a trace file, replies TRACE <hash> <processes>
+    TRACE <bytes>                           the next <bytes> bytes are a trace, replies the same as LOAD
+    JOB <id> <hash> <quantum> <mode> [KBs]  queue a run of a loaded trace, memory defaults to SYSMEM
+    RUN                                     run the queued jobs, replies RESULT <id> ... or ERROR <id> ...
+                                            for each job as it finishes, then DONE <jobs>
+    QUIT                                    close the connection
+    SHUTDOWN                                close the connection and stop the daemon
+Traces are kept parsed between requests and connections, found by the hash of their text, so loading the
+same trace again costs only the hash.
+*/
+
+int server_run(char* socket_path, int threads);
+int server_client(char* socket_path);
+
+#endif
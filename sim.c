@@ -0,0 +1,655 @@
+#include "sim.h"
+#include "process.h"
+#include "processqueue.h"
+#include "memory.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "telemetry.h"
+#include "profile.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Reports an event to whoever is driving the simulation
+static void emit(Sim_t* sim, int type, Process_t* process, int* frames, int frame_cnt) {
+    Sim_event_t event = {type, sim->cycle, process, frames, frame_cnt, sim->process_q->length};
+    sim->events += 1;
+    if (sim->on_event != NULL) {
+        PROF_BEGIN(PROF_OUTPUT);
+        sim->on_event(sim, &event, sim->event_data);
+        PROF_END(PROF_OUTPUT);
+    }
+}
+
+// Runs the process on the CPU for one quantum
+static void run_quantum(Sim_t* sim) {
+    Process_t* process = sim->process_q->head->process;
+    //underflow protection
+    if (sim->options.quantum > process->duration) {
+        process->duration = 0;
+    } else {
+        process->duration -= sim->options.quantum;
+    }
+}
+
+// Memory backends. Each memory model provides these hooks, and SIM_BACKEND below stamps out a copy of the
+// scheduling loop calling them directly, so the per-cycle path never has to check which model is in use:
+//   NAME_init(sim)                 creates the backend's memory
+//   NAME_arrivals(sim)             moves newly submitted processes into the process queue
+//   NAME_finished(process)         checks if the process at the head of the queue is done
+//   NAME_release(sim, process)     frees the memory of a finished process
+//   NAME_load(sim)                 gets memory for the process about to start, may reorder the queue
+//   NAME_print_running(sim, event) prints a RUNNING line with the backend's memory details
+//   NAME_mem_usage(sim)            fraction of memory in use, for telemetry
+//   NAME_free_space(sim)           free holes or frames left, for telemetry
+struct Sim_backend {
+    int alloc_mode;
+    void (*init)(Sim_t* sim);
+    void (*cycle)(Sim_t* sim);
+    void (*print_running)(Sim_t* sim, Sim_event_t* event);
+    double (*mem_usage)(Sim_t* sim);
+    int (*free_space)(Sim_t* sim);
+};
+
+/*
+The process manager runs in cycles. A cycle occurs after one quantum has elapsed. The process
+manager has its own notion of time, referred to from here on as the simulation time. The simulation
+time (TS ) starts at 0 and increases by the length of the quantum (Q) every cycle. For this project,
+Q will be an integer value between 1 and 3 (1 ≤ Q ≤ 3).
+*/
+#define SIM_BACKEND(NAME, MODE)                                                                 \
+static void NAME##_cycle(Sim_t* sim) {                                                          \
+    queue_t* process_q = sim->process_q;                                                        \
+    sim->requeued = NULL;                                                                       \
+    PROF_BEGIN(PROF_ARRIVALS);                                                                  \
+    NAME##_arrivals(sim);                                                                       \
+    PROF_END(PROF_ARRIVALS);                                                                    \
+    /* if no process in queue, finish cycle */                                                  \
+    if (process_q->head == NULL) {                                                              \
+        return;                                                                                 \
+    }                                                                                           \
+    /* if currently running process is finished, eject it from CPU and queue */                 \
+    if (NAME##_finished(process_q->head->process)) {                                            \
+        Process_t* process = dequeue(process_q);                                                \
+        NAME##_release(sim, process);                                                           \
+        process->finish_time = sim->cycle;                                                      \
+        if (sim->stats != NULL) stats_record(sim->stats, process);                              \
+        emit(sim, SIM_FINISHED, process, NULL, 0);                                              \
+    }                                                                                           \
+    /* if not finished, take top of the queue to the back */                                   \
+    else if (sim->cycle != 0) {                                                                 \
+        PROF_BEGIN(PROF_REQUEUE);                                                               \
+        sim->requeued = requeue(process_q);                                                     \
+        PROF_END(PROF_REQUEUE);                                                                 \
+    }                                                                                           \
+    /* if no process, finish cycle */                                                           \
+    if (process_q->head == NULL) {                                                              \
+        return;                                                                                 \
+    }                                                                                           \
+    /* a new process has started */                                                             \
+    if (process_q->head->process->state != RUNNING) {                                          \
+        NAME##_load(sim);                                                                       \
+        process_q->head->process->state = RUNNING;                                              \
+        emit(sim, SIM_RUNNING, process_q->head->process, NULL, 0);                              \
+    }                                                                                           \
+    run_quantum(sim);                                                                           \
+}                                                                                               \
+static const Sim_backend_t NAME##_backend = {MODE, NAME##_init, NAME##_cycle, NAME##_print_running,     \
+        NAME##_mem_usage, NAME##_free_space};
+
+// Infinite memory, every process always fits
+static void infinite_init(Sim_t* sim) {
+    (void) sim;
+}
+
+// add newly submitted processes to the queue
+static void infinite_arrivals(Sim_t* sim) {
+    add_processes(sim->processes, sim->process_q, sim->cycle);
+}
+
+static int infinite_finished(Process_t* process) {
+    return process->duration == 0;
+}
+
+static void infinite_release(Sim_t* sim, Process_t* process) {
+    (void) sim;
+    process->state = FINISHED; // put in queue functions?
+}
+
+static void infinite_load(Sim_t* sim) {
+    (void) sim;
+}
+
+static void infinite_print_running(Sim_t* sim, Sim_event_t* event) {
+    (void) sim;
+    inf_print_running_message(event->cycle, event->process);
+}
+
+static double infinite_mem_usage(Sim_t* sim) {
+    (void) sim;
+    return 0;
+}
+
+static int infinite_free_space(Sim_t* sim) {
+    (void) sim;
+    return 0;
+}
+
+SIM_BACKEND(infinite, INFINITE)
+
+// Contiguous memory, allocated first-fit from the c_Memory_t block list
+static void firstfit_init(Sim_t* sim) {
+    sim->c_memory = create_c_memory_block(NULL, sim->options.memory_size, 0);
+}
+
+#define firstfit_arrivals infinite_arrivals
+
+static int firstfit_finished(Process_t* process) {
+    return process->state == RUNNING && process->duration == 0;
+}
+
+static void firstfit_release(Sim_t* sim, Process_t* process) {
+    c_eject_mem(sim->c_memory, process);
+}
+
+// Counts an allocation attempt, sampling the fragmentation it faced if allocator statistics are wanted
+static void contiguous_cnt_alloc(Sim_t* sim, int injected, int steps, double frag) {
+    c_cnt_alloc(&sim->alloc_stats, injected, steps);
+    if (sim->options.alloc_stats) {
+        sim->alloc_stats.frag += frag;
+        sim->alloc_stats.frag_samples += 1;
+    }
+}
+
+// processes that do not fit are skipped until one does
+static void firstfit_load(Sim_t* sim) {
+    queue_t* process_q = sim->process_q;
+    while (process_q->head->process->allocated == FALSE) {
+        int steps;
+        double frag = sim->options.alloc_stats ? c_ext_fragmentation(sim->c_memory) : 0;
+        PROF_BEGIN(PROF_C_INJECT);
+        int injected = c_inject_mem(sim->c_memory, process_q->head->process, &steps);
+        PROF_END(PROF_C_INJECT);
+        contiguous_cnt_alloc(sim, injected, steps, frag);
+        if (injected) {
+            break;
+        }
+        PROF_BEGIN(PROF_REQUEUE);
+        requeue(process_q);
+        PROF_END(PROF_REQUEUE);
+    }
+}
+
+static void firstfit_print_running(Sim_t* sim, Sim_event_t* event) {
+    c_print_running_message(event->cycle, event->process, sim->c_memory);
+}
+
+static double firstfit_mem_usage(Sim_t* sim) {
+    return c_calc_mem_usage(sim->c_memory);
+}
+
+static int firstfit_free_space(Sim_t* sim) {
+    return c_cnt_holes(sim->c_memory);
+}
+
+SIM_BACKEND(firstfit, FIRSTFIT)
+
+// Contiguous memory laid out like first-fit, but holes are found through size class bins
+static void segregated_init(Sim_t* sim) {
+    sim->c_memory = create_c_memory_block(NULL, sim->options.memory_size, 0);
+    sim->s_memory = create_s_memory(sim->c_memory, sim->processes);
+}
+
+#define segregated_arrivals infinite_arrivals
+#define segregated_finished firstfit_finished
+#define segregated_print_running firstfit_print_running
+#define segregated_mem_usage firstfit_mem_usage
+#define segregated_free_space firstfit_free_space
+
+static void segregated_release(Sim_t* sim, Process_t* process) {
+    s_eject_mem(sim->s_memory, process);
+}
+
+// processes that do not fit are skipped until one does
+static void segregated_load(Sim_t* sim) {
+    queue_t* process_q = sim->process_q;
+    while (process_q->head->process->allocated == FALSE) {
+        int steps;
+        double frag = sim->options.alloc_stats ? c_ext_fragmentation(sim->c_memory) : 0;
+        PROF_BEGIN(PROF_C_INJECT);
+        int injected = s_inject_mem(sim->s_memory, process_q->head->process, &steps);
+        PROF_END(PROF_C_INJECT);
+        contiguous_cnt_alloc(sim, injected, steps, frag);
+        if (injected) {
+            break;
+        }
+        PROF_BEGIN(PROF_REQUEUE);
+        requeue(process_q);
+        PROF_END(PROF_REQUEUE);
+    }
+}
+
+SIM_BACKEND(segregated, SEGREGATED)
+
+// Paged and virtual memory share the f_Memory_t frame table, arrivals and release
+static void frames_init(Sim_t* sim) {
+    sim->f_memory = create_f_memory_table(sim->options.memory_size, PAGESIZE, sim->options.huge_frames);
+    if (sim->options.numa_nodes > 1) {
+        f_set_numa(sim->f_memory, sim->options.numa_nodes, sim->options.numa_policy);
+    }
+    sim->f_memory->sharing = has_shared_pages(sim->processes);
+    if (sim->options.alloc_mode == VIRTUAL && sim->options.swap_ratio > 0) {
+        z_create_pool(sim->f_memory, sim->options.swap_percent, sim->options.swap_ratio,
+                sim->options.swap_pool_latency, sim->options.swap_disk_latency);
+    }
+    // a virtual process is first assumed to need only the pages it cannot run without, and its working set
+    // grows as it faults
+    for (int i=0; sim->options.alloc_mode == VIRTUAL && i<sim->processes->total_processes; i++) {
+        Process_t* process = &sim->processes->array[i];
+        process->working_set = process->pages < REQ_PAGES ? process->pages : REQ_PAGES;
+    }
+}
+
+// Empties a list of ejected frames 'len' long, ended by -2
+static void frames_clear_ejected(int* ejected_mem, int len) {
+    for (int i=0; i<len; i++) {
+        ejected_mem[i] = -1;
+    }
+    ejected_mem[len] = -2;
+}
+
+// Reports and counts the frames an ejection freed, there is no EVICTED line if sharers still map all of them
+static void frames_emit_evicted(Sim_t* sim, int* ejected_mem, int len) {
+    int freed = f_cnt_listed(ejected_mem);
+    if (freed > 0) {
+        emit(sim, SIM_EVICTED, NULL, ejected_mem, len);
+        f_cnt_eviction(sim->f_memory, freed);
+    }
+}
+
+// Suspends admitted processes from the back of the queue, the ones round robin runs last, while the working sets
+// of all admitted processes no longer fit in memory. Their pages are evicted, and they wait at the front of the
+// suspended queue to be readmitted once there is room. The process on the CPU is never suspended.
+static void frames_suspend(Sim_t* sim, int capacity) {
+    queue_t* process_q = sim->process_q;
+    int demand = 0;
+    for (node_t* curr = process_q->head; curr != NULL; curr = curr->next) {
+        demand += curr->process->working_set;
+    }
+    while (demand > capacity && process_q->length > 1) {
+        Process_t* process = withdraw(process_q);
+        int ejected_mem[process->pages + 1];
+        frames_clear_ejected(ejected_mem, process->pages);
+        // evicted like any other pages, so they go to the swap pool if there is one
+        v_eject_mem(ejected_mem, process, sim->f_memory, process->pages);
+        frames_emit_evicted(sim, ejected_mem, process->pages);
+        process->state = SUSPENDED;
+        process->admit_time = sim->cycle;
+        process->suspends += 1;
+        push(sim->suspended_q, process);
+        demand -= process->working_set;
+    }
+}
+
+// add newly submitted processes to the queue, holding them back or suspending admitted ones if memory is overcommitted
+static void frames_arrivals(Sim_t* sim) {
+    if (sim->options.load_control) {
+        int capacity = sim->f_memory->num_frame - (sim->f_memory->pool != NULL ? sim->f_memory->pool->reserved : 0);
+        frames_suspend(sim, capacity);
+        admit_processes(sim->processes, sim->suspended_q, sim->process_q, capacity, sim->cycle);
+    } else {
+        add_processes(sim->processes, sim->process_q, sim->cycle);
+    }
+}
+
+static void frames_release(Sim_t* sim, Process_t* process) {
+    int ejected_mem[process->pages + 1];
+    frames_clear_ejected(ejected_mem, process->pages);
+    f_eject_mem(ejected_mem, sim->f_memory, process);
+    frames_emit_evicted(sim, ejected_mem, process->pages);
+}
+
+// Counts the page table of the process about to start, and stalls it for any pages on another NUMA node when
+// they were just loaded, and for reloading evicted pages from the swap tier. The NUMA penalty scales with the
+// share of remote pages. A stall holds the CPU without counting as run time, so a process that keeps getting
+// reloaded still makes progress however long the stall. The working set follows the pages the process runs
+// from, growing to them when it faulted and shrinking to them when it did not.
+static void frames_dispatch(Sim_t* sim, Process_t* process, int faults) {
+    f_Memory_t* memory = sim->f_memory;
+    if (memory->sharing) {
+        if (sim->options.cow_writes) f_cow_write(memory, process, sim->options.cow_writes);
+        f_cnt_sharing(memory);
+    }
+    f_cnt_dispatch(memory, process);
+    int loaded = v_cnt_allocated(process);
+    if (memory->faults == faults || loaded > process->working_set) {
+        process->working_set = loaded;
+    }
+    if (memory->nodes > 1 && sim->options.remote_penalty && memory->faults != faults && loaded > 0) {
+        unsigned int penalty = ceil((double)sim->options.remote_penalty * f_remote_pages(memory, process) / loaded);
+        sim->stall += penalty;
+        memory->remote_penalty += penalty;
+    }
+    if (memory->pool != NULL && memory->pool->pending > 0) {
+        unsigned int reload = ceil(memory->pool->pending);
+        memory->pool->pending = 0;
+        sim->stall += reload;
+        memory->pool->charged += reload;
+    }
+}
+
+static void frames_print_running(Sim_t* sim, Sim_event_t* event) {
+    f_print_running_message(event->cycle, event->process, sim->f_memory, sim->options.compact_frames);
+}
+
+static double frames_mem_usage(Sim_t* sim) {
+    return f_mem_usage(sim->f_memory);
+}
+
+static int frames_free_space(Sim_t* sim) {
+    return f_cnt_free_pages(sim->f_memory);
+}
+
+// Paged memory, a process needs all of its pages loaded to run
+#define paged_init frames_init
+#define paged_arrivals frames_arrivals
+#define paged_finished firstfit_finished
+#define paged_release frames_release
+#define paged_print_running frames_print_running
+#define paged_mem_usage frames_mem_usage
+#define paged_free_space frames_free_space
+
+static void paged_load(Sim_t* sim) {
+    queue_t* process_q = sim->process_q;
+    f_Memory_t* memory = sim->f_memory;
+    // prefer a process already in memory over one that would evict others
+    if (sim->options.resident_window) {
+        f_pick_resident(memory, process_q, sim->options.resident_window, PAGED, sim->requeued);
+    }
+    int faults = memory->faults;
+    if (process_q->head->process->allocated == FALSE) {
+        int ejected_mem[memory->num_frame + 1];
+        int ejected = f_inject_mem(ejected_mem, memory, process_q->head->process, process_q);
+        if (ejected > 0) {
+            emit(sim, SIM_EVICTED, NULL, ejected_mem, memory->num_frame);
+            f_cnt_eviction(memory, ejected);
+        }
+    }
+    frames_dispatch(sim, process_q->head->process, faults);
+}
+
+SIM_BACKEND(paged, PAGED)
+
+// Virtual memory, a process can run with only REQ_PAGES of its pages loaded
+#define virtual_init frames_init
+#define virtual_arrivals frames_arrivals
+#define virtual_finished firstfit_finished
+#define virtual_release frames_release
+#define virtual_print_running frames_print_running
+#define virtual_mem_usage frames_mem_usage
+#define virtual_free_space frames_free_space
+
+static void virtual_load(Sim_t* sim) {
+    queue_t* process_q = sim->process_q;
+    f_Memory_t* memory = sim->f_memory;
+    // prefer a process already in memory over one that would evict others
+    if (sim->options.resident_window) {
+        f_pick_resident(memory, process_q, sim->options.resident_window, VIRTUAL, sim->requeued);
+    }
+    int faults = memory->faults;
+    if (v_cnt_allocated(process_q->head->process) < REQ_PAGES) {
+        int ejected_mem[REQ_PAGES + 1];
+        int ejected = v_inject_mem(ejected_mem, process_q->head->process, memory, process_q);
+        if (ejected > 0) {
+            emit(sim, SIM_EVICTED, NULL, ejected_mem, REQ_PAGES);
+            f_cnt_eviction(memory, ejected);
+        }
+    }
+    frames_dispatch(sim, process_q->head->process, faults);
+}
+
+SIM_BACKEND(virtual, VIRTUAL)
+
+// Finds the backend simulating the given memory model
+static const Sim_backend_t* find_backend(int alloc_mode) {
+    switch (alloc_mode) {
+        case FIRSTFIT:
+            return &firstfit_backend;
+        case SEGREGATED:
+            return &segregated_backend;
+        case PAGED:
+            return &paged_backend;
+        case VIRTUAL:
+            return &virtual_backend;
+        default:
+            return &infinite_backend;
+    }
+}
+
+// Simulates one cycle, or marks the simulation done once every process has finished
+static void sim_cycle(Sim_t* sim) {
+    PROF_BEGIN(PROF_IS_COMPLETE);
+    int complete = is_complete(sim->processes);
+    PROF_END(PROF_IS_COMPLETE);
+    if (complete == TRUE) {
+        sim->done = TRUE;
+        sim->makespan = sim->cycle - sim->options.quantum;
+        return;
+    }
+    if (sim->options.checkpoint_file) {
+        Snapshot_t now = {sim->cycle, sim->options.alloc_mode, sim->processes, sim->process_q, 
+                sim->suspended_q, sim->c_memory, sim->f_memory, sim->alloc_stats};
+        snapshot_checkpoint(&sim->options, &now);
+    }
+    sim->backend->cycle(sim);
+    if (sim->telemetry != NULL && sim->cycle >= sim->telemetry->next) {
+        node_t* head = sim->process_q->head;
+        int running = head != NULL && head->process->state == RUNNING ? head->process - sim->processes->array : -1;
+        telemetry_sample(sim->telemetry, sim->cycle, sim->process_q->length, sim->backend->mem_usage(sim),
+                sim->backend->free_space(sim), running);
+    }
+    // the process on the CPU waited on memory before its quantum
+    sim->cycle += sim->options.quantum + sim->stall;
+    sim->stall = 0;
+}
+
+// Checks every process fits in memory on its own, a process that never fits would keep the simulation running
+// forever. Returns the problem or NULL.
+const char* sim_check(Process_list_t* processes, Sim_options_t* options) {
+    if (options->alloc_mode == INFINITE) {
+        return NULL;
+    }
+    int memory_size = options->memory_size ? options->memory_size : SYSMEM;
+    for (int i=0; i<processes->total_processes; i++) {
+        int memory = processes->array[i].memory;
+        // virtual memory only needs the pages a process cannot run without
+        if (options->alloc_mode == VIRTUAL && memory > REQ_PAGES*PAGESIZE) {
+            memory = REQ_PAGES*PAGESIZE;
+        }
+        if (memory > memory_size) {
+            return "process larger than memory";
+        }
+    }
+    return NULL;
+}
+
+// Sets up a simulation starting at cycle 0, the processes must outlive it and are changed as it runs
+Sim_t* sim_create(Process_list_t* processes, Sim_options_t* options) {
+    Sim_t* sim = (Sim_t*) calloc(1, sizeof(Sim_t));
+    assert(sim);
+    sim->options = *options;
+    if (options->checkpoint_file != NULL) {
+        sim->options.checkpoint_file = strdup(options->checkpoint_file);
+    }
+    if (options->telemetry_file != NULL) {
+        sim->options.telemetry_file = strdup(options->telemetry_file);
+    }
+    if (sim->options.memory_size == 0) {
+        sim->options.memory_size = SYSMEM;
+    }
+    sim->processes = processes;
+    sim->backend = find_backend(options->alloc_mode);
+    sim->process_q = create_queue();
+    sim->suspended_q = create_queue();
+    sim->backend->init(sim);
+    if (options->percentiles) {
+        sim->stats = create_stats();
+    }
+    if (options->telemetry_interval) {
+        sim->telemetry = create_telemetry(options->telemetry_interval);
+    }
+    return sim;
+}
+
+// Sets up a simulation carrying on from a snapshot, taking over its queues and memory. The memory model
+// comes from the snapshot, everything else from the given options.
+Sim_t* sim_resume(Snapshot_t* snapshot, Sim_options_t* options) {
+    Sim_t* sim = (Sim_t*) calloc(1, sizeof(Sim_t));
+    assert(sim);
+    sim->options = *options;
+    sim->options.alloc_mode = snapshot->alloc_mode;
+    sim->backend = find_backend(snapshot->alloc_mode);
+    if (options->checkpoint_file != NULL) {
+        sim->options.checkpoint_file = strdup(options->checkpoint_file);
+    }
+    if (options->telemetry_file != NULL) {
+        sim->options.telemetry_file = strdup(options->telemetry_file);
+    }
+    sim->processes = snapshot->processes;
+    sim->cycle = snapshot->cycle;
+    sim->process_q = snapshot->process_q;
+    sim->suspended_q = snapshot->suspended_q;
+    sim->c_memory = snapshot->c_memory;
+    sim->f_memory = snapshot->f_memory;
+    sim->alloc_stats = snapshot->alloc_stats;
+    if (sim->options.alloc_mode == SEGREGATED) {
+        sim->s_memory = create_s_memory(sim->c_memory, sim->processes);
+    }
+    if (sim->f_memory != NULL) {
+        sim->f_memory->huge_frames = options->huge_frames;
+        if (options->numa_nodes > 1) {
+            f_set_numa(sim->f_memory, options->numa_nodes, options->numa_policy);
+        }
+    }
+    if (options->percentiles) {
+        // processes that finished before the snapshot still count
+        sim->stats = create_stats();
+        for (int i=0; i<sim->processes->total_processes; i++) {
+            if (sim->processes->array[i].state == FINISHED) {
+                stats_record(sim->stats, &sim->processes->array[i]);
+            }
+        }
+    }
+    if (options->telemetry_interval) {
+        sim->telemetry = create_telemetry(options->telemetry_interval);
+    }
+    return sim;
+}
+
+void sim_set_event_handler(Sim_t* sim, Sim_event_fn on_event, void* data) {
+    sim->on_event = on_event;
+    sim->event_data = data;
+}
+
+// Runs until the next event is reported, returns FALSE once the simulation is done
+int sim_step(Sim_t* sim) {
+    int events = sim->events;
+    while (!sim->done && sim->events == events) {
+        sim_cycle(sim);
+    }
+    return !sim->done;
+}
+
+// Runs until the simulation time reaches the given cycle, returns FALSE once the simulation is done
+int sim_run_until(Sim_t* sim, unsigned int cycle) {
+    while (!sim->done && sim->cycle < cycle) {
+        sim_cycle(sim);
+    }
+    return !sim->done;
+}
+
+// Runs the simulation to completion
+void sim_run(Sim_t* sim) {
+    while (!sim->done) {
+        sim_cycle(sim);
+    }
+}
+
+// Turnaround, overhead and makespan of a finished simulation
+void sim_get_stats(Sim_t* sim, Sim_stats_t* stats) {
+    find_statistics(sim->processes, sim->makespan, stats);
+}
+
+// Event handler printing the simulation log to stdout
+void sim_print_event(Sim_t* sim, Sim_event_t* event, void* data) {
+    (void) data;
+    switch (event->type) {
+        case SIM_RUNNING:
+            sim->backend->print_running(sim, event);
+            break;
+        case SIM_FINISHED:
+            print_finished_message(event->cycle, event->process, event->queue_length);
+            break;
+        case SIM_EVICTED:
+            print_evicted_message(event->cycle, event->frames, event->frame_cnt, sim->options.compact_frames);
+            break;
+    }
+}
+
+// Displays the statistics of a finished simulation, along with those of any optional policies
+void sim_print_report(Sim_t* sim) {
+    Sim_options_t* options = &sim->options;
+    find_and_print_statisics(sim->processes, sim->makespan);
+    if (sim->stats != NULL) stats_print(sim->stats);
+    if (options->alloc_stats && sim->c_memory != NULL) c_print_alloc_stats(&sim->alloc_stats);
+    if (sim->f_memory == NULL) {
+        return;
+    }
+    if (options->load_control) print_load_control_stats(sim->processes);
+    if (options->huge_frames || options->load_control || options->resident_window) {
+        f_print_paging_stats(sim->f_memory);
+    }
+    if (options->resident_window) printf("Resident bypasses %d\n", sim->f_memory->bypasses);
+    if (sim->f_memory->nodes > 1) f_print_node_stats(sim->f_memory);
+    if (sim->f_memory->sharing) f_print_sharing_stats(sim->f_memory);
+    if (sim->f_memory->pool != NULL) z_print_stats(sim->f_memory->pool);
+}
+
+// Writes the telemetry samples to the file given in the options, or as CSV to stderr without one so they stay
+// out of the event log
+void sim_save_telemetry(Sim_t* sim) {
+    if (sim->telemetry == NULL) {
+        return;
+    }
+    if (sim->options.telemetry_file != NULL) {
+        telemetry_save(sim->telemetry, sim->processes, sim->options.telemetry_file);
+    } else {
+        telemetry_print(sim->telemetry, sim->processes, stderr);
+    }
+}
+
+// Frees the simulation's queues and memory, the processes are left to the caller
+void sim_destroy(Sim_t* sim) {
+    while (sim->process_q->head != NULL) {
+        node_t* next = sim->process_q->head->next;
+        free(sim->process_q->head);
+        sim->process_q->head = next;
+    }
+    while (sim->suspended_q->head != NULL) {
+        node_t* next = sim->suspended_q->head->next;
+        free(sim->suspended_q->head);
+        sim->suspended_q->head = next;
+    }
+    free(sim->process_q);
+    free(sim->suspended_q);
+    if (sim->c_memory != NULL) c_block_free(sim->c_memory);
+    free(sim->s_memory);
+    if (sim->f_memory != NULL) f_table_free(sim->f_memory);
+    free(sim->options.checkpoint_file);
+    free(sim->options.telemetry_file);
+    free(sim->stats);
+    free(sim->telemetry);
+    free(sim);
+}
@@ -0,0 +1,67 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "process.h"
+#include "processqueue.h"
+#include "memory.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "telemetry.h"
+
+// Event types reported while a simulation runs
+#define SIM_RUNNING 1
+#define SIM_FINISHED 2
+#define SIM_EVICTED 3
+
+typedef struct {
+    int type;               // SIM_RUNNING, SIM_FINISHED or SIM_EVICTED
+    unsigned int cycle;     // simulation time of the event
+    Process_t* process;     // process started or finished, NULL for evictions
+    int* frames;            // evicted frames (-1 entries are unused), NULL for other events
+    int frame_cnt;          // length of frames
+    int queue_length;       // processes left in the process queue
+} Sim_event_t;
+
+struct Sim;
+typedef void (*Sim_event_fn)(struct Sim* sim, Sim_event_t* event, void* data);
+
+// Memory model plugged into the scheduler, see sim.c
+typedef struct Sim_backend Sim_backend_t;
+
+// One independent simulation, nothing is shared between simulations so many can run side by side
+typedef struct Sim {
+    Sim_options_t options;      // settings, a private copy
+    const Sim_backend_t* backend; // memory model being simulated
+    Process_list_t* processes;  // processes being simulated, owned by the caller
+    unsigned int cycle;         // current simulation time
+    unsigned int stall;         // cycles the process on the CPU waits on memory this cycle, on top of the quantum
+    unsigned int makespan;      // time the last process finished, valid once done
+    int done;                   // boolean value if every process has finished
+    Process_t* requeued;        // process moved to the back of the queue this cycle, NULL if none
+    int events;                 // events reported so far
+    queue_t* process_q;         // processes ready to run, head is on the CPU
+    queue_t* suspended_q;       // processes held back by load control
+    c_Memory_t* c_memory;       // block list for first-fit and segregated memory, NULL otherwise
+    s_Memory_t* s_memory;       // size class bins over c_memory for segregated memory, NULL otherwise
+    f_Memory_t* f_memory;       // frame table for paged/virtual memory, NULL otherwise
+    c_Alloc_stats_t alloc_stats;// allocation counters for continuous memory
+    Stats_t* stats;             // tail statistics, NULL if they are not wanted
+    Telemetry_t* telemetry;     // time series samples, NULL if they are not wanted
+    Sim_event_fn on_event;      // called for each event, NULL to run silently
+    void* event_data;           // passed through to on_event
+} Sim_t;
+
+const char* sim_check(Process_list_t* processes, Sim_options_t* options);
+Sim_t* sim_create(Process_list_t* processes, Sim_options_t* options);
+Sim_t* sim_resume(Snapshot_t* snapshot, Sim_options_t* options);
+void sim_set_event_handler(Sim_t* sim, Sim_event_fn on_event, void* data);
+int sim_step(Sim_t* sim);
+int sim_run_until(Sim_t* sim, unsigned int cycle);
+void sim_run(Sim_t* sim);
+void sim_get_stats(Sim_t* sim, Sim_stats_t* stats);
+void sim_print_event(Sim_t* sim, Sim_event_t* event, void* data);
+void sim_print_report(Sim_t* sim);
+void sim_save_telemetry(Sim_t* sim);
+void sim_destroy(Sim_t* sim);
+
+#endif
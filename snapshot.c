@@ -0,0 +1,270 @@
+#include "snapshot.h"
+#include "process.h"
+#include "processqueue.h"
+#include "memory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define SNAPSHOT_MAGIC "ALLOCATE-SNAPSHOT"
+#define SNAPSHOT_VERSION 6
+
+// Stops the program if a snapshot file does not hold what was expected
+static void expect(int ok) {
+    if (!ok) {
+        fprintf(stderr, "allocate: malformed snapshot file\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Memory owners are stored as pointers to a process's PID, turns one back into its index in the process list
+static int owner_index(Process_list_t* processes, char* PID) {
+    if (PID == NULL) {
+        return -1;
+    }
+    return ((char*)PID - (char*)processes->array) / sizeof(Process_t);
+}
+
+static char* owner_PID(Process_list_t* processes, int index) {
+    if (index == -1) {
+        return NULL;
+    }
+    expect(index >= 0 && index < processes->total_processes);
+    return processes->array[index].PID;
+}
+
+static void save_queue(FILE* fptr, Process_list_t* processes, queue_t* queue) {
+    if (queue == NULL) {
+        fprintf(fptr, "0\n");
+        return;
+    }
+    fprintf(fptr, "%d", queue->length);
+    for (node_t* curr = queue->head; curr != NULL; curr = curr->next) {
+        fprintf(fptr, " %ld", (long)(curr->process - processes->array));
+    }
+    fprintf(fptr, "\n");
+}
+
+// Rebuilds a queue without going through enqueue, so process states stay as they were saved
+static queue_t* load_queue(FILE* fptr, Process_list_t* processes) {
+    queue_t* queue = create_queue();
+    node_t* tail = NULL;
+    int length, index;
+    expect(fscanf(fptr, "%d", &length) == 1);
+    for (int i=0; i<length; i++) {
+        expect(fscanf(fptr, "%d", &index) == 1);
+        expect(index >= 0 && index < processes->total_processes);
+        node_t* node = create_node(&processes->array[index]);
+        if (tail == NULL) {
+            queue->head = node;
+        } else {
+            tail->next = node;
+        }
+        tail = node;
+    }
+    queue->length = length;
+    return queue;
+}
+
+// Writes the whole simulation state to a text file
+void snapshot_save(char* filepath, Snapshot_t* snapshot) {
+    Process_list_t* processes = snapshot->processes;
+    FILE* fptr = fopen(filepath, "w");
+    assert(fptr);
+
+    fprintf(fptr, "%s %d\n%u %d\n", SNAPSHOT_MAGIC, SNAPSHOT_VERSION, snapshot->cycle, snapshot->alloc_mode);
+
+    fprintf(fptr, "%d\n", processes->total_processes);
+    for (int i=0; i<processes->total_processes; i++) {
+        Process_t* p = &processes->array[i];
+        fprintf(fptr, "%s %u %u %u %u %hu %d %hd %d %d %u %u %d %d %d %d %d %d", p->PID, p->start_time,
+                p->finish_time, p->service_time, p->duration, p->memory, p->pages, p->allocated, p->state,
+                p->working_set, p->admit_time, p->waited, p->suspends, p->skips, p->home_node, p->group,
+                p->shared, p->written);
+        for (int j=0; j<p->pages; j++) {
+            fprintf(fptr, " %d", p->page_table[j]);
+        }
+        // where evicted pages are kept with a swap pool
+        fprintf(fptr, "\n%d", p->swap != NULL);
+        for (int j=0; p->swap != NULL && j<p->pages; j++) {
+            fprintf(fptr, " %d", p->swap[j]);
+        }
+        fprintf(fptr, "\n");
+    }
+
+    save_queue(fptr, processes, snapshot->process_q);
+    save_queue(fptr, processes, snapshot->suspended_q);
+
+    // first-fit/segregated block list, as offset, size and owner of each block, then the allocation counters
+    int blocks = 0;
+    for (c_Memory_t* curr = snapshot->c_memory; curr != NULL; curr = curr->next) {
+        blocks += 1;
+    }
+    fprintf(fptr, "%d\n", blocks);
+    for (c_Memory_t* curr = snapshot->c_memory; curr != NULL; curr = curr->next) {
+        fprintf(fptr, "%hu %hu %d\n", curr->offset, curr->size, owner_index(processes, curr->PID));
+    }
+    c_Alloc_stats_t* alloc = &snapshot->alloc_stats;
+    fprintf(fptr, "%d %d %ld %d %.17g %d\n", alloc->allocs, alloc->failures, alloc->steps, alloc->max_steps,
+            alloc->frag, alloc->frag_samples);
+
+    // paged/virtual frame table, counters then the owner of each frame
+    f_Memory_t* table = snapshot->f_memory;
+    if (table == NULL) {
+        fprintf(fptr, "0\n");
+    } else {
+        fprintf(fptr, "%d %d %d %d %d %d %d %d %d %ld %ld %d\n", table->num_frame, table->total_mem, 
+                table->huge_frames, table->faults, table->promotions, table->demotions, table->evict_msgs,
+                table->evicted_frames, table->dispatches, table->pt_entries, table->small_entries, table->bypasses);
+        // NUMA counters, the node layout itself comes from the options the simulation is resumed with
+        fprintf(fptr, "%d %ld", table->next_home, table->remote_penalty);
+        for (int n=0; n<MAX_NODES; n++) {
+            Node_stats_t* node = &table->node_stats[n];
+            fprintf(fptr, " %d %ld %ld", node->peak, node->local, node->remote);
+        }
+        fprintf(fptr, "\n");
+        int reserved = table->pool != NULL ? table->pool->reserved : 0;
+        for (int i=0; i<table->num_frame; i++) {
+            // the swap pool's frames are marked taken again when it is read back
+            int owner = i < table->num_frame - reserved ? owner_index(processes, table->frames[i]) : -1;
+            fprintf(fptr, "%d%c", owner, i+1 == table->num_frame ? '\n' : ' ');
+        }
+        // sharing counters, then the reference count, group and page of each frame
+        fprintf(fptr, "%d %ld %d %d %d %d\n", table->sharing, table->attaches, table->cow_copies, table->cow_deferred,
+                table->peak_frames, table->peak_private);
+        for (int i=0; table->sharing && i<table->num_frame; i++) {
+            fprintf(fptr, "%d %d %d\n", table->refs[i], table->share_group[i], table->share_page[i]);
+        }
+        // swap pool settings and counters, then the pages in it oldest first
+        z_Pool_t* pool = table->pool;
+        fprintf(fptr, "%d\n", pool != NULL);
+        if (pool != NULL) {
+            fprintf(fptr, "%d %d %.17g %.17g %.17g %ld %ld %ld %ld %ld %d\n", pool->reserved, pool->capacity,
+                    pool->pool_latency, pool->disk_latency, pool->pending, pool->stores, pool->writebacks,
+                    pool->hits, pool->misses, pool->charged, pool->used);
+            for (int k=0; k<pool->used; k++) {
+                fprintf(fptr, "%ld %d\n", (long)(pool->entries[k].process - processes->array), pool->entries[k].page);
+            }
+        }
+    }
+    fclose(fptr);
+}
+
+// Reads back a snapshot written by snapshot_save
+Snapshot_t* snapshot_load(char* filepath) {
+    FILE* fptr = fopen(filepath, "r");
+    assert(fptr);
+    Snapshot_t* snapshot = (Snapshot_t*) calloc(1, sizeof(Snapshot_t));
+    assert(snapshot);
+
+    char magic[32];
+    int version;
+    expect(fscanf(fptr, "%31s %d", magic, &version) == 2);
+    expect(strcmp(magic, SNAPSHOT_MAGIC) == 0 && version == SNAPSHOT_VERSION);
+    expect(fscanf(fptr, "%u %d", &snapshot->cycle, &snapshot->alloc_mode) == 2);
+
+    Process_list_t* processes = (Process_list_t*) malloc(sizeof(Process_list_t));
+    assert(processes);
+    expect(fscanf(fptr, "%d", &processes->total_processes) == 1);
+    processes->array = (Process_t*) malloc(sizeof(Process_t)*(processes->total_processes + 1));
+    assert(processes->array);
+    for (int i=0; i<processes->total_processes; i++) {
+        Process_t* p = &processes->array[i];
+        expect(fscanf(fptr, "%8s %u %u %u %u %hu %d %hd %d %d %u %u %d %d %d %d %d %d", p->PID, &p->start_time,
+                &p->finish_time, &p->service_time, &p->duration, &p->memory, &p->pages, &p->allocated, &p->state,
+                &p->working_set, &p->admit_time, &p->waited, &p->suspends, &p->skips, &p->home_node, &p->group,
+                &p->shared, &p->written) == 18);
+        p->page_table = (int*) malloc(sizeof(int)*p->pages);
+        assert(p->page_table);
+        for (int j=0; j<p->pages; j++) {
+            expect(fscanf(fptr, "%d", &p->page_table[j]) == 1);
+        }
+        int swap;
+        expect(fscanf(fptr, "%d", &swap) == 1);
+        p->swap = swap ? (int*) malloc(sizeof(int)*p->pages) : NULL;
+        for (int j=0; swap && j<p->pages; j++) {
+            expect(fscanf(fptr, "%d", &p->swap[j]) == 1);
+        }
+        p->block = NULL;
+    }
+    snapshot->processes = processes;
+    snapshot->process_q = load_queue(fptr, processes);
+    snapshot->suspended_q = load_queue(fptr, processes);
+
+    int blocks, owner;
+    unsigned short offset, size;
+    c_Memory_t* tail = NULL;
+    expect(fscanf(fptr, "%d", &blocks) == 1);
+    for (int i=0; i<blocks; i++) {
+        expect(fscanf(fptr, "%hu %hu %d", &offset, &size, &owner) == 3);
+        c_Memory_t* block = create_c_memory_block(owner_PID(processes, owner), size, offset);
+        if (tail == NULL) {
+            snapshot->c_memory = block;
+        } else {
+            tail->next = block;
+        }
+        tail = block;
+    }
+    c_Alloc_stats_t* alloc = &snapshot->alloc_stats;
+    expect(fscanf(fptr, "%d %d %ld %d %lf %d", &alloc->allocs, &alloc->failures, &alloc->steps, &alloc->max_steps,
+            &alloc->frag, &alloc->frag_samples) == 6);
+
+    int num_frame, total_mem, huge_frames;
+    expect(fscanf(fptr, "%d", &num_frame) == 1);
+    if (num_frame > 0) {
+        expect(fscanf(fptr, "%d %d", &total_mem, &huge_frames) == 2);
+        f_Memory_t* table = create_f_memory_table(total_mem, total_mem/num_frame, huge_frames);
+        expect(fscanf(fptr, "%d %d %d %d %d %d %ld %ld %d", &table->faults, &table->promotions, &table->demotions,
+                &table->evict_msgs, &table->evicted_frames, &table->dispatches, &table->pt_entries,
+                &table->small_entries, &table->bypasses) == 9);
+        expect(fscanf(fptr, "%d %ld", &table->next_home, &table->remote_penalty) == 2);
+        for (int n=0; n<MAX_NODES; n++) {
+            Node_stats_t* node = &table->node_stats[n];
+            expect(fscanf(fptr, "%d %ld %ld", &node->peak, &node->local, &node->remote) == 3);
+        }
+        for (int i=0; i<num_frame; i++) {
+            expect(fscanf(fptr, "%d", &owner) == 1);
+            table->frames[i] = owner_PID(processes, owner);
+        }
+        expect(fscanf(fptr, "%d %ld %d %d %d %d", &table->sharing, &table->attaches, &table->cow_copies,
+                &table->cow_deferred, &table->peak_frames, &table->peak_private) == 6);
+        for (int i=0; table->sharing && i<num_frame; i++) {
+            expect(fscanf(fptr, "%d %d %d", &table->refs[i], &table->share_group[i], &table->share_page[i]) == 3);
+        }
+        int has_pool;
+        expect(fscanf(fptr, "%d", &has_pool) == 1);
+        if (has_pool) {
+            z_Pool_t* pool = (z_Pool_t*) calloc(1, sizeof(z_Pool_t));
+            assert(pool);
+            expect(fscanf(fptr, "%d %d %lf %lf %lf %ld %ld %ld %ld %ld %d", &pool->reserved, &pool->capacity,
+                    &pool->pool_latency, &pool->disk_latency, &pool->pending, &pool->stores, &pool->writebacks,
+                    &pool->hits, &pool->misses, &pool->charged, &pool->used) == 11);
+            expect(pool->reserved >= 0 && pool->reserved <= num_frame && pool->used >= 0 && pool->used <= pool->capacity);
+            pool->entries = (z_Entry_t*) malloc(sizeof(z_Entry_t)*(pool->capacity + 1));
+            assert(pool->entries);
+            for (int k=0; k<pool->used; k++) {
+                int index;
+                expect(fscanf(fptr, "%d %d", &index, &pool->entries[k].page) == 2);
+                expect(index >= 0 && index < processes->total_processes);
+                pool->entries[k].process = &processes->array[index];
+            }
+            table->pool = pool;
+            z_reserve(table);
+        }
+        f_recount(table);
+        snapshot->f_memory = table;
+    }
+    fclose(fptr);
+    return snapshot;
+}
+
+// Saves the state once the simulation reaches the requested checkpoint cycle, then stops checking
+void snapshot_checkpoint(Sim_options_t* options, Snapshot_t* snapshot) {
+    if (options->checkpoint_file == NULL || snapshot->cycle < options->checkpoint_cycle) {
+        return;
+    }
+    snapshot_save(options->checkpoint_file, snapshot);
+    free(options->checkpoint_file);
+    options->checkpoint_file = NULL;
+}
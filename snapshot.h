@@ -0,0 +1,24 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "process.h"
+#include "processqueue.h"
+#include "memory.h"
+
+// Full simulation state at the start of a cycle, enough to pick the simulation back up from there
+typedef struct {
+    unsigned int cycle;         // cycle the simulation stopped at
+    int alloc_mode;             // memory model that was simulated
+    Process_list_t* processes;  // every process, finished or not
+    queue_t* process_q;         // process queue in running order
+    queue_t* suspended_q;       // processes held back by load control
+    c_Memory_t* c_memory;       // block list for first-fit and segregated memory, NULL otherwise
+    f_Memory_t* f_memory;       // frame table for paged/virtual memory, NULL otherwise
+    c_Alloc_stats_t alloc_stats;// allocation counters for continuous memory
+} Snapshot_t;
+
+void snapshot_save(char* filepath, Snapshot_t* snapshot);
+Snapshot_t* snapshot_load(char* filepath);
+void snapshot_checkpoint(Sim_options_t* options, Snapshot_t* snapshot);
+
+#endif
@@ -0,0 +1,115 @@
+#include "stats.h"
+#include "process.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+static const double PERCENTILES[] = {0.5, 0.9, 0.99, 0.999};
+#define NUM_PERCENTILES 4
+static const char* CLASS_NAMES[SIZE_CLASSES] = {"all", "small", "medium", "large"};
+
+// Finds the bucket a value belongs in, small values get a bucket each
+static int hist_bucket(unsigned int value) {
+    if (value < HIST_SUB) {
+        return value;
+    }
+    int exponent = 31 - __builtin_clz(value);
+    int sub = (value >> (exponent - HIST_SUB_BITS)) & (HIST_SUB - 1);
+    return (exponent - HIST_SUB_BITS + 1) * HIST_SUB + sub;
+}
+
+// Largest value that falls in the given bucket
+static unsigned long long hist_bucket_top(int bucket) {
+    if (bucket < HIST_SUB) {
+        return bucket;
+    }
+    int exponent = bucket / HIST_SUB + HIST_SUB_BITS - 1;
+    unsigned long long width = 1ULL << (exponent - HIST_SUB_BITS);
+    return (HIST_SUB + bucket % HIST_SUB) * width + width - 1;
+}
+
+void hist_record(Histogram_t* hist, unsigned int value) {
+    hist->counts[hist_bucket(value)] += 1;
+    hist->total += 1;
+    if (value > hist->max) {
+        hist->max = value;
+    }
+}
+
+// Returns the value at the given percentile (0.5 for the median), rounded up to the top of its bucket
+unsigned int hist_percentile(Histogram_t* hist, double percentile) {
+    if (hist->total == 0) {
+        return 0;
+    }
+    unsigned long long rank = ceil(percentile * hist->total);
+    unsigned long long seen = 0;
+    for (int i=0; i<HIST_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            unsigned long long top = hist_bucket_top(i);
+            return top < hist->max ? top : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+Stats_t* create_stats() {
+    Stats_t* stats = (Stats_t*) calloc(1, sizeof(Stats_t));
+    assert(stats);
+    return stats;
+}
+
+static int size_class(Process_t* process) {
+    if (process->memory <= SMALL_PROCESS) {
+        return CLASS_SMALL;
+    }
+    if (process->memory <= MEDIUM_PROCESS) {
+        return CLASS_MEDIUM;
+    }
+    return CLASS_LARGE;
+}
+
+// Adds a finished process to the statistics, the process is not needed afterwards
+void stats_record(Stats_t* stats, Process_t* process) {
+    unsigned int turnaround = process->finish_time - process->start_time;
+    unsigned int wait = turnaround > process->service_time ? turnaround - process->service_time : 0;
+    unsigned int overhead = process->service_time ? round(100.0 * turnaround / process->service_time) : 0;
+    int classes[2] = {CLASS_ALL, size_class(process)};
+
+    for (int i=0; i<2; i++) {
+        hist_record(&stats->turnaround[classes[i]], turnaround);
+        hist_record(&stats->overhead[classes[i]], overhead);
+        hist_record(&stats->wait[classes[i]], wait);
+    }
+}
+
+static void print_row(char* name, Histogram_t* hist, int size_class, int hundredths) {
+    if (hist->total == 0) {
+        return;
+    }
+    printf("%s %s %llu", name, CLASS_NAMES[size_class], hist->total);
+    for (int i=0; i<NUM_PERCENTILES; i++) {
+        unsigned int value = hist_percentile(hist, PERCENTILES[i]);
+        if (hundredths) {
+            printf(" %.2f", value / 100.0);
+        } else {
+            printf(" %u", value);
+        }
+    }
+    printf("\n");
+}
+
+// Displays p50, p90, p99 and p99.9 of turnaround, overhead and wait time for each size class
+void stats_print(Stats_t* stats) {
+    printf("Percentiles count p50 p90 p99 p99.9\n");
+    for (int i=0; i<SIZE_CLASSES; i++) {
+        print_row("Turnaround", &stats->turnaround[i], i, FALSE);
+    }
+    for (int i=0; i<SIZE_CLASSES; i++) {
+        print_row("Overhead", &stats->overhead[i], i, TRUE);
+    }
+    for (int i=0; i<SIZE_CLASSES; i++) {
+        print_row("Wait", &stats->wait[i], i, FALSE);
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "process.h"
+
+// Log bucketed histogram, every power of two range is split into HIST_SUB linear buckets so any value is
+// known to within 1/HIST_SUB of itself, in a fixed amount of memory no matter how many values are recorded
+#define HIST_SUB_BITS 5
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((33 - HIST_SUB_BITS) * HIST_SUB)
+
+// Process size classes the statistics are broken down by, CLASS_ALL covers every process
+#define CLASS_ALL 0
+#define CLASS_SMALL 1      // up to SMALL_PROCESS KBs
+#define CLASS_MEDIUM 2     // up to MEDIUM_PROCESS KBs
+#define CLASS_LARGE 3
+#define SIZE_CLASSES 4
+#define SMALL_PROCESS 128
+#define MEDIUM_PROCESS 512
+
+typedef struct {
+    unsigned long long counts[HIST_BUCKETS];
+    unsigned long long total;   // values recorded
+    unsigned int max;           // largest value recorded
+} Histogram_t;
+
+// Tail statistics of finished processes, filled in as each one finishes
+typedef struct {
+    Histogram_t turnaround[SIZE_CLASSES];
+    Histogram_t overhead[SIZE_CLASSES];    // in hundredths, so 1.25 is stored as 125
+    Histogram_t wait[SIZE_CLASSES];        // turnaround less service time
+} Stats_t;
+
+void hist_record(Histogram_t* hist, unsigned int value);
+unsigned int hist_percentile(Histogram_t* hist, double percentile);
+Stats_t* create_stats();
+void stats_record(Stats_t* stats, Process_t* process);
+void stats_print(Stats_t* stats);
+
+#endif
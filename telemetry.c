@@ -0,0 +1,79 @@
+#include "telemetry.h"
+#include "process.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+Telemetry_t* create_telemetry(unsigned int interval) {
+    Telemetry_t* telemetry = (Telemetry_t*) malloc(sizeof(Telemetry_t));
+    assert(telemetry);
+    telemetry->interval = interval > 0 ? interval : 1;
+    telemetry->next = 0;
+    telemetry->count = 0;
+    return telemetry;
+}
+
+// Halves the number of samples by keeping every other one, so a run of any length fits in the buffer
+static void telemetry_decimate(Telemetry_t* telemetry) {
+    for (int i=0; 2*i<telemetry->count; i++) {
+        telemetry->cycle[i] = telemetry->cycle[2*i];
+        telemetry->queue_length[i] = telemetry->queue_length[2*i];
+        telemetry->mem_usage[i] = telemetry->mem_usage[2*i];
+        telemetry->free_space[i] = telemetry->free_space[2*i];
+        telemetry->running[i] = telemetry->running[2*i];
+    }
+    telemetry->count = (telemetry->count + 1) / 2;
+    telemetry->interval *= 2;
+}
+
+// Records the state at the given cycle if a sample is due
+void telemetry_sample(Telemetry_t* telemetry, unsigned int cycle, int queue_length, double mem_usage, 
+        int free_space, int running) {
+    if (cycle < telemetry->next) {
+        return;
+    }
+    if (telemetry->count == TELEMETRY_CAPACITY) {
+        telemetry_decimate(telemetry);
+    }
+    int i = telemetry->count++;
+    telemetry->cycle[i] = cycle;
+    telemetry->queue_length[i] = queue_length;
+    telemetry->mem_usage[i] = mem_usage * 1000 + 0.5;
+    telemetry->free_space[i] = free_space;
+    telemetry->running[i] = running;
+    telemetry->next = cycle + telemetry->interval;
+}
+
+// Prints the samples as CSV with a header line
+void telemetry_print(Telemetry_t* telemetry, Process_list_t* processes, FILE* fptr) {
+    fprintf(fptr, "cycle,queue-length,mem-usage,free-space,running\n");
+    for (int i=0; i<telemetry->count; i++) {
+        fprintf(fptr, "%u,%u,%.1f,%u,%s\n", telemetry->cycle[i], telemetry->queue_length[i], 
+                telemetry->mem_usage[i] / 10.0, telemetry->free_space[i],
+                telemetry->running[i] == -1 ? "" : processes->array[telemetry->running[i]].PID);
+    }
+}
+
+// Writes the samples out, as CSV if the file name ends in .csv and as columns of raw integers otherwise.
+// The binary layout is the magic, sample count and interval followed by each column in the struct's order.
+void telemetry_save(Telemetry_t* telemetry, Process_list_t* processes, char* filepath) {
+    size_t len = strlen(filepath);
+    int csv = len >= 4 && strcmp(filepath + len - 4, ".csv") == 0;
+    FILE* fptr = fopen(filepath, csv ? "w" : "wb");
+    assert(fptr);
+
+    if (csv) {
+        telemetry_print(telemetry, processes, fptr);
+    } else {
+        unsigned int header[2] = {telemetry->count, telemetry->interval};
+        fwrite(TELEMETRY_MAGIC, 1, strlen(TELEMETRY_MAGIC), fptr);
+        fwrite(header, sizeof(unsigned int), 2, fptr);
+        fwrite(telemetry->cycle, sizeof(unsigned int), telemetry->count, fptr);
+        fwrite(telemetry->queue_length, sizeof(unsigned int), telemetry->count, fptr);
+        fwrite(telemetry->mem_usage, sizeof(unsigned short), telemetry->count, fptr);
+        fwrite(telemetry->free_space, sizeof(unsigned int), telemetry->count, fptr);
+        fwrite(telemetry->running, sizeof(int), telemetry->count, fptr);
+    }
+    fclose(fptr);
+}
@@ -0,0 +1,29 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "process.h"
+#include <stdio.h>
+
+// Samples kept in memory, once full every other sample is dropped and the interval doubles
+#define TELEMETRY_CAPACITY 4096
+#define TELEMETRY_MAGIC "ALLOCTEL"
+
+// Time series of the simulation state, stored a column per field
+typedef struct {
+    unsigned int interval;                          // cycles between samples
+    unsigned int next;                              // cycle the next sample is due
+    int count;                                      // samples taken
+    unsigned int cycle[TELEMETRY_CAPACITY];
+    unsigned int queue_length[TELEMETRY_CAPACITY];  // processes in the process queue
+    unsigned short mem_usage[TELEMETRY_CAPACITY];   // in tenths of a percent
+    unsigned int free_space[TELEMETRY_CAPACITY];    // free holes (first-fit) or free frames (paged/virtual)
+    int running[TELEMETRY_CAPACITY];                // index of the process on the CPU, -1 if idle
+} Telemetry_t;
+
+Telemetry_t* create_telemetry(unsigned int interval);
+void telemetry_sample(Telemetry_t* telemetry, unsigned int cycle, int queue_length, double mem_usage, 
+        int free_space, int running);
+void telemetry_print(Telemetry_t* telemetry, Process_list_t* processes, FILE* fptr);
+void telemetry_save(Telemetry_t* telemetry, Process_list_t* processes, char* filepath);
+
+#endif
@@ -0,0 +1,229 @@
+#include "tune.h"
+#include "sim.h"
+#include "process.h"
+#include "memory.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+// cycles, in quanta, a candidate runs between checks if it is already beaten
+#define TUNE_CHECK 64
+
+// Adds a candidate to the search
+static void add_candidate(Tune_t* tune, Sim_options_t* options) {
+    tune->candidates = (Tune_candidate_t*) realloc(tune->candidates, sizeof(Tune_candidate_t)*(tune->total + 1));
+    assert(tune->candidates);
+    Tune_candidate_t* candidate = &tune->candidates[tune->total++];
+    candidate->options = *options;
+    candidate->finished = FALSE;
+    candidate->pruned = FALSE;
+    candidate->pareto = FALSE;
+}
+
+// Adds a candidate for each policy of the memory model that changes how processes are placed or replaced
+static void add_policies(Tune_t* tune, Sim_options_t* options) {
+    Sim_options_t candidate = *options;
+    switch (options->alloc_mode) {
+        case FIRSTFIT:
+        case SEGREGATED:
+            candidate.alloc_mode = FIRSTFIT;
+            add_candidate(tune, &candidate);
+            candidate.alloc_mode = SEGREGATED;
+            add_candidate(tune, &candidate);
+            break;
+        case PAGED:
+        case VIRTUAL:
+            for (int load_control=0; load_control<=1; load_control++) {
+                for (int window=0; window<=2; window+=2) {
+                    for (int policy=NUMA_LOCAL; policy<=NUMA_SPILL; policy++) {
+                        if (options->numa_nodes <= 1 && policy != options->numa_policy) {
+                            continue;
+                        }
+                        candidate.load_control = load_control;
+                        candidate.resident_window = window;
+                        candidate.numa_policy = policy;
+                        add_candidate(tune, &candidate);
+                    }
+                }
+            }
+            break;
+        default:
+            add_candidate(tune, &candidate);
+    }
+}
+
+// Checks if stats a are at least as good as b on every measure and better on one
+static int dominates(Sim_stats_t* a, Sim_stats_t* b) {
+    if (a->makespan > b->makespan || a->avg_turnaround > b->avg_turnaround || a->max_overhead > b->max_overhead) {
+        return FALSE;
+    }
+    return a->makespan < b->makespan || a->avg_turnaround < b->avg_turnaround || a->max_overhead < b->max_overhead;
+}
+
+// The best a running simulation can still end with. Unfinished processes finish no earlier than now, nor
+// before their start time plus service time.
+static void lower_bound(Sim_t* sim, Sim_stats_t* bound) {
+    Process_list_t* processes = sim->processes;
+    double turnaround = 0, max_overhead = 0;
+    unsigned int makespan = 0;
+    for (int i=0; i<processes->total_processes; i++) {
+        Process_t* process = &processes->array[i];
+        unsigned int finish = process->finish_time;
+        if (process->state != FINISHED) {
+            finish = sim->cycle;
+            if (process->start_time + process->service_time > finish) {
+                finish = process->start_time + process->service_time;
+            }
+        }
+        turnaround += finish - process->start_time;
+        double overhead = (double)(finish - process->start_time) / process->service_time;
+        if (overhead > max_overhead) {
+            max_overhead = overhead;
+        }
+        if (finish > makespan) {
+            makespan = finish;
+        }
+    }
+    bound->avg_turnaround = ceil(turnaround/processes->total_processes);
+    bound->max_overhead = max_overhead;
+    bound->makespan = makespan;
+}
+
+// Checks if a finished candidate already beats anything the running simulation can still get to
+static int beaten(Tune_t* tune, Sim_t* sim) {
+    Sim_stats_t bound;
+    lower_bound(sim, &bound);
+    int beaten = FALSE;
+    pthread_mutex_lock(&tune->lock);
+    for (int i=0; i<tune->total && !beaten; i++) {
+        beaten = tune->candidates[i].finished && dominates(&tune->candidates[i].stats, &bound);
+    }
+    pthread_mutex_unlock(&tune->lock);
+    return beaten;
+}
+
+// Runs candidates off the shared list until none are left, each on its own copy of the trace
+static void* tune_worker(void* data) {
+    Tune_t* tune = (Tune_t*) data;
+    while (TRUE) {
+        pthread_mutex_lock(&tune->lock);
+        int i = tune->next < tune->total ? tune->next++ : -1;
+        pthread_mutex_unlock(&tune->lock);
+        if (i == -1) {
+            return NULL;
+        }
+        Tune_candidate_t* candidate = &tune->candidates[i];
+        Process_list_t* processes = copy_processes(tune->processes);
+        Sim_t* sim = sim_create(processes, &candidate->options);
+        int pruned = FALSE;
+        while (sim_run_until(sim, sim->cycle + TUNE_CHECK*candidate->options.quantum)) {
+            if (beaten(tune, sim)) {
+                pruned = TRUE;
+                break;
+            }
+        }
+        Sim_stats_t stats;
+        sim_get_stats(sim, &stats);
+        pthread_mutex_lock(&tune->lock);
+        if (pruned) {
+            candidate->pruned = TRUE;
+            tune->pruned += 1;
+        } else {
+            candidate->stats = stats;
+            candidate->finished = TRUE;
+        }
+        pthread_mutex_unlock(&tune->lock);
+        sim_destroy(sim);
+        free_processes(processes);
+    }
+}
+
+// Tries every quantum from qmin to qmax, and every policy of the memory model if asked, on a pool of threads.
+// Runs that another run already beats on every measure are stopped early, what is left over is the Pareto set.
+Tune_t* tune_run(Process_list_t* processes, Sim_options_t* options, unsigned int qmin, unsigned int qmax,
+        int policies, int threads) {
+    Tune_t* tune = (Tune_t*) calloc(1, sizeof(Tune_t));
+    assert(tune);
+    tune->processes = processes;
+    pthread_mutex_init(&tune->lock, NULL);
+
+    // the runs are silent, nothing is saved along the way
+    Sim_options_t candidate = *options;
+    candidate.checkpoint_file = NULL;
+    candidate.telemetry_interval = 0;
+    candidate.telemetry_file = NULL;
+    candidate.percentiles = FALSE;
+    for (unsigned int q=qmin; q<=qmax; q++) {
+        candidate.quantum = q;
+        if (policies) {
+            add_policies(tune, &candidate);
+        } else {
+            add_candidate(tune, &candidate);
+        }
+    }
+
+    if (threads < 1) threads = 1;
+    if (threads > tune->total) threads = tune->total;
+    pthread_t* workers = (pthread_t*) malloc(sizeof(pthread_t)*threads);
+    assert(workers);
+    for (int i=0; i<threads; i++) {
+        int created = pthread_create(&workers[i], NULL, tune_worker, tune);
+        assert(created == 0);
+    }
+    for (int i=0; i<threads; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+
+    for (int i=0; i<tune->total; i++) {
+        Tune_candidate_t* c = &tune->candidates[i];
+        c->pareto = c->finished;
+        for (int j=0; j<tune->total && c->pareto; j++) {
+            c->pareto = !(tune->candidates[j].finished && dominates(&tune->candidates[j].stats, &c->stats));
+        }
+    }
+    return tune;
+}
+
+static const char* mode_name(int alloc_mode) {
+    switch (alloc_mode) {
+        case FIRSTFIT:
+            return "first-fit";
+        case SEGREGATED:
+            return "segregated";
+        case PAGED:
+            return "paged";
+        case VIRTUAL:
+            return "virtual";
+        default:
+            return "infinite";
+    }
+}
+
+// Displays the Pareto set, one line per setting in the order they were tried
+void tune_print(Tune_t* tune) {
+    static const char* NUMA_NAMES[] = {"local", "interleave", "spill"};
+    printf("Candidates %d pruned %d\n", tune->total, tune->pruned);
+    for (int i=0; i<tune->total; i++) {
+        Tune_candidate_t* c = &tune->candidates[i];
+        if (!c->pareto) {
+            continue;
+        }
+        Sim_options_t* options = &c->options;
+        printf("quantum=%u,mode=%s", options->quantum, mode_name(options->alloc_mode));
+        if (options->alloc_mode == PAGED || options->alloc_mode == VIRTUAL) {
+            printf(",load-control=%d,resident-window=%d", options->load_control, options->resident_window);
+            if (options->numa_nodes > 1) printf(",numa-policy=%s", NUMA_NAMES[options->numa_policy]);
+        }
+        printf(",makespan=%d,turnaround=%.f,max-overhead=%.2f\n", c->stats.makespan, c->stats.avg_turnaround,
+                c->stats.max_overhead);
+    }
+}
+
+// Frees a search, the trace is left to the caller
+void tune_free(Tune_t* tune) {
+    pthread_mutex_destroy(&tune->lock);
+    free(tune->candidates);
+    free(tune);
+}
@@ -0,0 +1,31 @@
+#ifndef TUNE_H
+#define TUNE_H
+
+#include "process.h"
+#include <pthread.h>
+
+// One setting tried by the tuner and how it did
+typedef struct {
+    Sim_options_t options;      // quantum and policies being tried, everything else as given
+    Sim_stats_t stats;          // results, valid once finished
+    int finished;               // boolean value if the run went to the end
+    int pruned;                 // boolean value if the run was stopped early, another run already beats it
+    int pareto;                 // boolean value if no other run beats it on every measure
+} Tune_candidate_t;
+
+// A search over quantum and policies for one trace
+typedef struct {
+    Process_list_t* processes;  // trace every candidate is run on, each run gets its own copy
+    Tune_candidate_t* candidates;
+    int total;                  // candidates to try
+    int next;                   // next candidate a worker picks up
+    int pruned;                 // candidates stopped early
+    pthread_mutex_t lock;       // guards next, pruned and the results of finished candidates
+} Tune_t;
+
+Tune_t* tune_run(Process_list_t* processes, Sim_options_t* options, unsigned int qmin, unsigned int qmax,
+        int policies, int threads);
+void tune_print(Tune_t* tune);
+void tune_free(Tune_t* tune);
+
+#endif